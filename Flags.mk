@@ -1,4 +1,8 @@
 INC := $(INC)
 INC := $(addprefix -I,$(INC))
-CFLAGS += -g -O0 -Wall -Wextra -Wmissing-declarations -Wconversion -Wshadow -Wlogical-op -Waggregate-return -Wfloat-equal -Wsuggest-attribute=const -Wunused -Wuninitialized -Wno-unknown-warning-option -Wstrict-aliasing $(INC)
+WARNINGS := -Wall -Wextra -Wmissing-declarations -Wconversion -Wshadow -Wlogical-op -Waggregate-return -Wfloat-equal -Wsuggest-attribute=const -Wunused -Wuninitialized -Wno-unknown-warning-option -Wstrict-aliasing
+CFLAGS += -g -O0 $(WARNINGS) $(INC)
 
+
+# Benchmarks are built optimised, without the debug flags of CFLAGS (eg. BENCH_ARCH=-march=native for the AVX2 paths)
+BENCH_CFLAGS += -O2 -DNDEBUG $(WARNINGS) $(BENCH_ARCH) $(INC)
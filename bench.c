@@ -0,0 +1,534 @@
+/*
+ * File    : bench.c
+ * Created : 18/10/2026
+ * Modified: 18/10/2026
+ * Authors : Bogdan Ionescu
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "kJSON.h"
+
+#define array_size(array) (sizeof(array) / sizeof(array[0]))
+
+#define BUFFER_SIZE   (1 << 21)  // Output of one document, large enough that nothing is truncated
+#define ARRAY_MAX     (4096)     // Largest array inserted
+#define NEST_MAX      (256)      // Deepest nesting
+#define BLOB_SIZE     (64)       // Bytes of binary data per value
+#define TRIALS        (5)        // The fastest trial is reported
+#define TRIAL_NS      (20000000) // Minimum duration of a trial
+#define DOCUMENT_SIZE (16384)    // Elements inserted per document, scalars are counted as one
+
+#if CONFIG_KJSON_SMALLEST
+#define BUILD_LAYOUT "smallest"
+#else
+#define BUILD_LAYOUT "pretty"
+#endif
+
+#if CONFIG_KJSON_NO_FLOAT
+#define BUILD_FLOAT BUILD_LAYOUT "_nofloat"
+#else
+#define BUILD_FLOAT BUILD_LAYOUT
+#endif
+
+#if CONFIG_KJSON_HEADER_ONLY
+#define BUILD_NAME BUILD_FLOAT "_inline"
+#else
+#define BUILD_NAME BUILD_FLOAT
+#endif
+
+typedef void (*bench_run_t)(kjson_t *const jsonHandle, const size_t elements);
+
+typedef struct
+{
+   const char *name;  // Name of the benchmark, the function it times
+   bench_run_t run;   // Inserts one operation into the document
+   size_t elements;   // Elements per operation: array size, nesting depth, 1 for scalars
+   size_t operations; // Operations per document, the start and end of the document are spread over them
+} bench_t;
+
+typedef struct
+{
+   double nsPerOp;     // Time per operation
+   double mbPerSecond; // Output written per second
+   size_t bytesPerOp;  // Output per operation
+} result_t;
+
+static void Setup(void);
+static bool Time(const bench_t *const bench, result_t *const result);
+static uint64_t Now(void);
+static void PrintCsv(const bench_t *const bench, const result_t *const result);
+static void PrintJson(const bench_t *const bench, const result_t *const result);
+static void InsertMetric(kjson_t *const jsonHandle, const char *const key, const double value);
+
+static void RunString(kjson_t *const jsonHandle, const size_t elements);
+static void RunStringEscaped(kjson_t *const jsonHandle, const size_t elements);
+static void RunStringWithKey(kjson_t *const jsonHandle, const size_t elements);
+static void RunStringLiteralKey(kjson_t *const jsonHandle, const size_t elements);
+static void RunNumberLiteralKey(kjson_t *const jsonHandle, const size_t elements);
+static void RunBooleanLiteralKey(kjson_t *const jsonHandle, const size_t elements);
+static void RunNumber(kjson_t *const jsonHandle, const size_t elements);
+static void RunUnsignedNumber(kjson_t *const jsonHandle, const size_t elements);
+static void RunNumber64(kjson_t *const jsonHandle, const size_t elements);
+static void RunUnsignedNumber64(kjson_t *const jsonHandle, const size_t elements);
+#if !CONFIG_KJSON_NO_FLOAT
+static void RunFloat(kjson_t *const jsonHandle, const size_t elements);
+static void RunDouble(kjson_t *const jsonHandle, const size_t elements);
+static void RunDoubleShortest(kjson_t *const jsonHandle, const size_t elements);
+#endif
+static void RunBoolean(kjson_t *const jsonHandle, const size_t elements);
+static void RunNull(kjson_t *const jsonHandle, const size_t elements);
+static void RunBase64(kjson_t *const jsonHandle, const size_t elements);
+static void RunHex(kjson_t *const jsonHandle, const size_t elements);
+static void RunRaw(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayInt(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayUInt8(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayInt16(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayUInt32(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayInt64(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayUInt64(kjson_t *const jsonHandle, const size_t elements);
+#if !CONFIG_KJSON_NO_FLOAT
+static void RunArrayFloat(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayDouble(kjson_t *const jsonHandle, const size_t elements);
+#endif
+static void RunArrayString(kjson_t *const jsonHandle, const size_t elements);
+static void RunArrayBase64(kjson_t *const jsonHandle, const size_t elements);
+static void RunEnterObject(kjson_t *const jsonHandle, const size_t elements);
+static void RunEnterArray(kjson_t *const jsonHandle, const size_t elements);
+
+#define SCALAR(name, run) {name, run, 1, DOCUMENT_SIZE}
+#define SIZES(name, run)  {name, run, 16, DOCUMENT_SIZE / 16}, {name, run, 256, DOCUMENT_SIZE / 256}, {name, run, ARRAY_MAX, DOCUMENT_SIZE / ARRAY_MAX}
+#define DEPTHS(name, run) {name, run, 16, 64}, {name, run, NEST_MAX, 4} // Pretty lines grow with depth
+
+static const bench_t benches[] = {
+   SCALAR("kJSON_InsertString", RunString),
+   SCALAR("kJSON_InsertString(escaped)", RunStringEscaped),
+   SCALAR("kJSON_InsertStringWithKey", RunStringWithKey),
+   SCALAR("kJSON_InsertStringWithKey(literal)", RunStringLiteralKey),
+   SCALAR("kJSON_InsertNumberWithKey(literal)", RunNumberLiteralKey),
+   SCALAR("kJSON_InsertBooleanWithKey(literal)", RunBooleanLiteralKey),
+   SCALAR("kJSON_InsertNumber", RunNumber),
+   SCALAR("kJSON_InsertUnsignedNumber", RunUnsignedNumber),
+   SCALAR("kJSON_InsertNumber64", RunNumber64),
+   SCALAR("kJSON_InsertUnsignedNumber64", RunUnsignedNumber64),
+#if !CONFIG_KJSON_NO_FLOAT
+   SCALAR("kJSON_InsertFloat", RunFloat),
+   SCALAR("kJSON_InsertDouble", RunDouble),
+   SCALAR("kJSON_InsertDouble(shortest)", RunDoubleShortest),
+#endif
+   SCALAR("kJSON_InsertBoolean", RunBoolean),
+   SCALAR("kJSON_InsertNull", RunNull),
+   SCALAR("kJSON_InsertBase64", RunBase64),
+   SCALAR("kJSON_InsertHex", RunHex),
+   SCALAR("kJSON_InsertRaw", RunRaw),
+   SIZES("kJSON_InsertArrayInt", RunArrayInt),
+   SIZES("kJSON_InsertArrayUInt8", RunArrayUInt8),
+   SIZES("kJSON_InsertArrayInt16", RunArrayInt16),
+   SIZES("kJSON_InsertArrayUInt32", RunArrayUInt32),
+   SIZES("kJSON_InsertArrayInt64", RunArrayInt64),
+   SIZES("kJSON_InsertArrayUInt64", RunArrayUInt64),
+#if !CONFIG_KJSON_NO_FLOAT
+   SIZES("kJSON_InsertArrayFloat", RunArrayFloat),
+   SIZES("kJSON_InsertArrayDouble", RunArrayDouble),
+#endif
+   SIZES("kJSON_InsertArrayString", RunArrayString),
+   SIZES("kJSON_InsertArrayBase64", RunArrayBase64),
+   DEPTHS("kJSON_EnterObject", RunEnterObject),
+   DEPTHS("kJSON_EnterArray", RunEnterArray),
+};
+
+static char buffer[BUFFER_SIZE];
+static int ints[ARRAY_MAX];
+static uint8_t uint8s[ARRAY_MAX];
+static int16_t int16s[ARRAY_MAX];
+static uint32_t uint32s[ARRAY_MAX];
+static int64_t int64s[ARRAY_MAX];
+static uint64_t uint64s[ARRAY_MAX];
+#if !CONFIG_KJSON_NO_FLOAT
+static float floats[ARRAY_MAX];
+static double doubles[ARRAY_MAX];
+#endif
+static const char *strings[ARRAY_MAX];
+static uint8_t blob[BLOB_SIZE + ARRAY_MAX];
+static const void *blobs[ARRAY_MAX];
+static size_t blobLengths[ARRAY_MAX];
+static kjson_key_t preparedKey;
+static char preparedKeyBuffer[16];
+static unsigned int counter; // Changes the values between operations
+
+static const char *const words[] = {"sensor", "temperature", "humidity", "pressure", "voltage", "current", "status", "ok"};
+static const char raw[] = "{\"id\":42,\"name\":\"cached\",\"tags\":[\"a\",\"b\"],\"ok\":true}";
+
+int main(int argc, char **argv)
+{
+   bool json = false;
+   bool header = true;
+   const char *filter = NULL;
+   for (int i = 1; i < argc; i++)
+   {
+      if (0 == strcmp(argv[i], "--json"))
+      {
+         json = true;
+      }
+      else if (0 == strcmp(argv[i], "--csv"))
+      {
+         json = false;
+      }
+      else if (0 == strcmp(argv[i], "--no-header"))
+      {
+         header = false;
+      }
+      else if ('-' == argv[i][0])
+      {
+         fprintf(stderr, "Usage: %s [--csv|--json] [--no-header] [filter]\n", argv[0]);
+         return 1;
+      }
+      else
+      {
+         filter = argv[i];
+      }
+   }
+
+   Setup();
+   if (!json && header)
+   {
+      printf("build,benchmark,elements,ns_per_op,ns_per_element,bytes_per_op,mb_per_s\n");
+   }
+   for (size_t i = 0; i < array_size(benches); i++)
+   {
+      const bench_t *const bench = &benches[i];
+      if (filter && !strstr(bench->name, filter))
+      {
+         continue;
+      }
+      result_t result;
+      if (!Time(bench, &result))
+      {
+         fprintf(stderr, "%s(%zu): output truncated\n", bench->name, bench->elements);
+         return 1;
+      }
+      if (json)
+      {
+         PrintJson(bench, &result);
+      }
+      else
+      {
+         PrintCsv(bench, &result);
+      }
+      fflush(stdout);
+   }
+
+   return 0;
+}
+
+static void Setup(void)
+{
+   // Values of every width, so that the digit counts vary like real data
+   uint64_t seed = 0x9E3779B97F4A7C15u;
+   for (size_t i = 0; i < ARRAY_MAX; i++)
+   {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      const uint64_t value = seed >> (seed >> 58);
+      ints[i] = (int)(int32_t)value;
+      uint8s[i] = (uint8_t)value;
+      int16s[i] = (int16_t)value;
+      uint32s[i] = (uint32_t)value;
+      int64s[i] = (int64_t)value;
+      uint64s[i] = value;
+#if !CONFIG_KJSON_NO_FLOAT
+      floats[i] = (float)(int32_t)value / 1000.0f;
+      doubles[i] = (double)(int64_t)value / 1e6;
+#endif
+      strings[i] = words[i % array_size(words)];
+      blobs[i] = &blob[i];
+      blobLengths[i] = BLOB_SIZE / 4;
+   }
+   for (size_t i = 0; i < sizeof(blob); i++)
+   {
+      blob[i] = (uint8_t)(i * 131u);
+   }
+   kJSON_PrepareKey(&preparedKey, preparedKeyBuffer, sizeof(preparedKeyBuffer), "name", KJSON_ASCII_OFF);
+}
+
+static bool Time(const bench_t *const bench, result_t *const result)
+{
+   // Documents are written back to back until the trial is long enough
+   const size_t operations = bench->operations;
+   result->nsPerOp = 0;
+   for (int trial = 0; trial < TRIALS; trial++)
+   {
+      size_t documents = 0;
+      size_t bytes = 0;
+      const uint64_t start = Now();
+      uint64_t elapsed;
+      do
+      {
+         kjson_t json = KJSON_INITIALISE(buffer, sizeof(buffer));
+         kJSON_InitRoot(&json);
+         for (size_t i = 0; i < operations; i++)
+         {
+            bench->run(&json, bench->elements);
+         }
+         kJSON_ExitRoot(&json);
+         if (json.truncated)
+         {
+            return false;
+         }
+         bytes += json.size;
+         documents++;
+         elapsed = Now() - start;
+      } while (elapsed < TRIAL_NS);
+
+      const double nsPerOp = (double)elapsed / (double)(documents * operations);
+      if ((0 == trial) || (nsPerOp < result->nsPerOp))
+      {
+         result->nsPerOp = nsPerOp;
+         result->bytesPerOp = bytes / (documents * operations);
+         result->mbPerSecond = (double)bytes * 1e3 / (double)elapsed;
+      }
+   }
+   return true;
+}
+
+static uint64_t Now(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void PrintCsv(const bench_t *const bench, const result_t *const result)
+{
+   printf("%s,%s,%zu,%.2f,%.3f,%zu,%.1f\n", BUILD_NAME, bench->name, bench->elements, result->nsPerOp,
+          result->nsPerOp / (double)bench->elements, result->bytesPerOp, result->mbPerSecond);
+}
+
+static void PrintJson(const bench_t *const bench, const result_t *const result)
+{
+   // One record per line (NDJSON), written with the library being measured
+   static const kjson_format_t compact = KJSON_FORMAT_COMPACT;
+   char root[512];
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   json.format = &compact;
+
+   kJSON_InitRoot(&json);
+   kJSON_InsertString(&json, "build", BUILD_NAME);
+   kJSON_InsertString(&json, "benchmark", bench->name);
+   kJSON_InsertUnsignedNumber64(&json, "elements", bench->elements);
+   InsertMetric(&json, "ns_per_op", result->nsPerOp);
+   InsertMetric(&json, "ns_per_element", result->nsPerOp / (double)bench->elements);
+   kJSON_InsertUnsignedNumber64(&json, "bytes_per_op", result->bytesPerOp);
+   InsertMetric(&json, "mb_per_s", result->mbPerSecond);
+   kJSON_ExitRoot(&json);
+
+   printf("%s\n", root);
+}
+
+static void InsertMetric(kjson_t *const jsonHandle, const char *const key, const double value)
+{
+#if CONFIG_KJSON_NO_FLOAT
+   // The library is built without floats, the value is formatted here
+   char text[32];
+   const int length = snprintf(text, sizeof(text), "%.3f", value);
+   kJSON_InsertRaw(jsonHandle, key, text, (size_t)length);
+#else
+   kJSON_InsertDouble(jsonHandle, key, value, 3);
+#endif
+}
+
+static void RunString(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertString(jsonHandle, "name", words[counter++ % array_size(words)]);
+}
+
+static void RunStringEscaped(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertString(jsonHandle, "path", "C:\\logs\\\"today\"\n\tcaf\xC3\xA9");
+}
+
+static void RunStringWithKey(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertStringWithKey(jsonHandle, &preparedKey, words[counter++ % array_size(words)]);
+}
+
+static void RunStringLiteralKey(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertStringWithKey(jsonHandle, KJSON_KEY("name"), words[counter++ % array_size(words)]);
+}
+
+static void RunNumberLiteralKey(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertNumberWithKey(jsonHandle, KJSON_KEY("value"), ints[counter++ % ARRAY_MAX]);
+}
+
+static void RunBooleanLiteralKey(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertBooleanWithKey(jsonHandle, KJSON_KEY("ok"), counter++ & 1);
+}
+
+static void RunNumber(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertNumber(jsonHandle, "value", ints[counter++ % ARRAY_MAX]);
+}
+
+static void RunUnsignedNumber(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertUnsignedNumber(jsonHandle, "value", uint32s[counter++ % ARRAY_MAX]);
+}
+
+static void RunNumber64(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertNumber64(jsonHandle, "value", int64s[counter++ % ARRAY_MAX]);
+}
+
+static void RunUnsignedNumber64(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertUnsignedNumber64(jsonHandle, "value", uint64s[counter++ % ARRAY_MAX]);
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+static void RunFloat(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertFloat(jsonHandle, "value", floats[counter++ % ARRAY_MAX], 3);
+}
+
+static void RunDouble(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertDouble(jsonHandle, "value", doubles[counter++ % ARRAY_MAX], 6);
+}
+
+static void RunDoubleShortest(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertDouble(jsonHandle, "value", doubles[counter++ % ARRAY_MAX], KJSON_DECIMALS_SHORTEST);
+}
+#endif
+
+static void RunBoolean(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertBoolean(jsonHandle, "ok", counter++ & 1);
+}
+
+static void RunNull(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertNull(jsonHandle, "none");
+}
+
+static void RunBase64(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertBase64(jsonHandle, "data", &blob[counter++ % ARRAY_MAX], BLOB_SIZE);
+}
+
+static void RunHex(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertHex(jsonHandle, "digest", &blob[counter++ % ARRAY_MAX], BLOB_SIZE / 2);
+}
+
+static void RunRaw(kjson_t *const jsonHandle, const size_t elements)
+{
+   (void)elements;
+   kJSON_InsertRaw(jsonHandle, "cached", raw, sizeof(raw) - 1);
+}
+
+static void RunArrayInt(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayInt(jsonHandle, "values", ints, elements);
+}
+
+static void RunArrayUInt8(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayUInt8(jsonHandle, "values", uint8s, elements);
+}
+
+static void RunArrayInt16(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayInt16(jsonHandle, "values", int16s, elements);
+}
+
+static void RunArrayUInt32(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayUInt32(jsonHandle, "values", uint32s, elements);
+}
+
+static void RunArrayInt64(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayInt64(jsonHandle, "values", int64s, elements);
+}
+
+static void RunArrayUInt64(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayUInt64(jsonHandle, "values", uint64s, elements);
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+static void RunArrayFloat(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayFloat(jsonHandle, "values", floats, elements, 3);
+}
+
+static void RunArrayDouble(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayDouble(jsonHandle, "values", doubles, elements, 6);
+}
+#endif
+
+static void RunArrayString(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayString(jsonHandle, "values", strings, elements);
+}
+
+static void RunArrayBase64(kjson_t *const jsonHandle, const size_t elements)
+{
+   kJSON_InsertArrayBase64(jsonHandle, "values", blobs, blobLengths, elements);
+}
+
+static void RunEnterObject(kjson_t *const jsonHandle, const size_t elements)
+{
+   for (size_t i = 0; i < elements; i++)
+   {
+      kJSON_EnterObject(jsonHandle, "level");
+   }
+   kJSON_InsertNumber(jsonHandle, "depth", (int)elements);
+   for (size_t i = 0; i < elements; i++)
+   {
+      kJSON_ExitObject(jsonHandle);
+   }
+}
+
+static void RunEnterArray(kjson_t *const jsonHandle, const size_t elements)
+{
+   // Each level is an array holding one object, values in arrays have no key
+   for (size_t i = 0; i < elements; i++)
+   {
+      kJSON_EnterArray(jsonHandle, "level");
+      kJSON_EnterObject(jsonHandle, NULL);
+   }
+   kJSON_InsertNumber(jsonHandle, "depth", (int)elements);
+   for (size_t i = 0; i < elements; i++)
+   {
+      kJSON_ExitObject(jsonHandle);
+      kJSON_ExitArray(jsonHandle);
+   }
+}
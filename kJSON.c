@@ -16,9 +16,28 @@
 #include "kJSON.h"
 
 #include <stdint.h>
-#include <stdio.h>
 #include <string.h>
 
+#if !CONFIG_KJSON_NO_SIMD && defined(__GNUC__) && defined(__SSE2__)
+#include <immintrin.h>
+#define KJSON_SSE2 (1)
+#if defined(__SSSE3__)
+#define KJSON_SSSE3 (1)
+#endif
+#if defined(__AVX2__)
+#define KJSON_AVX2 (1)
+#endif
+#endif
+
+#if CONFIG_KJSON_STATS_CYCLES && !defined(KJSON_CYCLES)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define KJSON_CYCLES() __rdtsc()
+#else
+#error "CONFIG_KJSON_STATS_CYCLES needs KJSON_CYCLES() to read a cycle counter"
+#endif
+#endif
+
 //------------------------------------------------------------------------------
 // Module constant defines
 //------------------------------------------------------------------------------
@@ -30,49 +49,86 @@
 #define BOOLEAN_FALSE ("false")
 #define NULL_VALUE    ("null")
 
-#if CONFIG_KJSON_SMALLEST
-#define STRING               ("\"%s\":\"%s\",")
-#define NUMBER               ("\"%s\":%d,")
-#define UNSIGNED             ("\"%s\":%u,")
-#define FLOAT                ("\"%s\":%.*f,")
-#define BOOLEAN              ("\"%s\":%s,")
-#define ARRAY_KEY            ("\"%s\":[")
-#define ARRAY_VALUE_STRING   ("\"%s\",")
-#define ARRAY_VALUE_NULL     ("null,")
-#define ARRAY_VALUE_NUMBER   ("%d,")
-#define ARRAY_VALUE_UNSIGNED ("%u,")
-#define ARRAY_VALUE_FLOAT    ("%.*f,")
-#define ARRAY_END            ("],")
-#define ARRAY_TRIM           (char_size(","))
-#define OBJECT_KEY           ("\"%s\":{")
-#define OBJECT_KEYLESS       ("{")
-#define OBJECT_END           ("},")
+#define ARRAY_END       ("],")
+#define ARRAY_SEPARATOR (", ") // Pretty separator, the compact one is its first character
+#define KEY_END         ("\":") // The key separator of the format follows
+#define OBJECT_END      ("},")
+
+#define KEY_NAME(name) {.text = (name), .length = 0} // Key that is escaped on every insert
+
+// Key copies on the insert path are inlined in the header-only build, so that literal keys fold
+#if CONFIG_KJSON_HEADER_ONLY
+#define KJSON_INLINE inline
 #else
-#define STRING               ("\"%s\":\t\"%s\",")
-#define NUMBER               ("\"%s\":\t%d,")
-#define UNSIGNED             ("\"%s\":\t%u,")
-#define FLOAT                ("\"%s\":\t%.*f,")
-#define BOOLEAN              ("\"%s\":\t%s,")
-#define ARRAY_KEY            ("\"%s\":\t[")
-#define ARRAY_VALUE_STRING   ("\"%s\", ")
-#define ARRAY_VALUE_NULL     ("null, ")
-#define ARRAY_VALUE_NUMBER   ("%d, ")
-#define ARRAY_VALUE_UNSIGNED ("%u, ")
-#define ARRAY_VALUE_FLOAT    ("%.*f, ")
-#define ARRAY_END            ("],")
-#define ARRAY_TRIM           (char_size(", "))
-#define OBJECT_KEY           ("\"%s\":\t{")
-#define OBJECT_KEYLESS       ("{")
-#define OBJECT_END           ("},")
-#endif // CONFIG_KJSON_SMALLEST
+#define KJSON_INLINE
+#endif
+
+// The speculative string insert is kept out of line in the header-only build, its writer
+// is not inlined so a copy at every call site saves nothing
+#if CONFIG_KJSON_HEADER_ONLY && defined(__GNUC__)
+#define KJSON_OUTLINE __attribute__((noinline))
+#else
+#define KJSON_OUTLINE
+#endif
+
+#define UTF8_INVALID      (0xFFFFFFFF)
+#define UTF8_REPLACEMENT  (0xFFFD)
+#define REJECTED_LENGTH   (SIZE_MAX / 4) // Cannot fit, and a few of them added cannot overflow
+#define NO_FIT            (SIZE_MAX)     // Returned by the speculative writers when they run out of space
+#define NUMBER_BLOCK      (16)           // Array elements sized together before they are written
+#define SCAN_WINDOW       (64)           // Bytes classified together by the reformatter, one bit each
 
 #if !CONFIG_KJSON_NO_FLOAT
-#define FLOAT_MASK (0xFFFFFFFF)
+#define FLOAT_MANTISSA_BITS (23)
+#define FLOAT_EXPONENT_MASK (0xFF)
+#define FLOAT_BIAS          (150)
+#define FLOAT_MASK          (0xFFFFFFFF)
+
+#define DOUBLE_MANTISSA_BITS (52)
+#define DOUBLE_EXPONENT_MASK (0x7FF)
+#define DOUBLE_BIAS          (1075)
+
+#define FLOAT_POW5_INV_BITCOUNT  (59)
+#define FLOAT_POW5_BITCOUNT      (61)
+#define DOUBLE_POW5_INV_BITCOUNT (125)
+#define DOUBLE_POW5_BITCOUNT     (125)
+#define DOUBLE_POW5_TABLE_SIZE   (26)
+#define SHORTEST_FIXED_MIN       (-6) // Smallest decimal point position printed without an exponent
+#define SHORTEST_FIXED_MAX       (21) // Largest decimal point position printed without an exponent
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
 #define IS_FLOAT_NULL(value, nullValue) \
    ((*(uint32_t *)&(value) & FLOAT_MASK) == (*(uint32_t *)&(nullValue) & FLOAT_MASK))
 #endif
 
+#if CONFIG_KJSON_STATS
+#define STATS_INSERT(jsonHandle, type)      CountInsert((jsonHandle), (type))
+#define STATS_TRUNCATION(jsonHandle, size)  CountTruncation((jsonHandle), (size))
+#define STATS_PEAK(jsonHandle, size)        CountPeak((jsonHandle), (size))
+#define STATS_RESERVE(jsonHandle, size, fits) \
+   ((fits) ? CountPeak((jsonHandle), (jsonHandle)->size - GetSpare(jsonHandle) + (size)) : CountTruncation((jsonHandle), (size)))
+#define STATS_START(jsonHandle)             ((jsonHandle)->stats.start = (jsonHandle)->flushed + (jsonHandle)->size)
+#define STATS_OUTPUT(jsonHandle)            CountOutput((jsonHandle))
+// The size an entry needed is only measured when it did not fit
+#define STATS_COMMIT(jsonHandle, bytes, needed) \
+   CountCommit((jsonHandle), (NO_FIT == (bytes)) ? (needed) : 0)
+#else
+#define STATS_INSERT(jsonHandle, type)
+#define STATS_TRUNCATION(jsonHandle, size)
+#define STATS_PEAK(jsonHandle, size)
+#define STATS_RESERVE(jsonHandle, size, fits)
+#define STATS_START(jsonHandle)
+#define STATS_OUTPUT(jsonHandle)
+#define STATS_COMMIT(jsonHandle, bytes, needed)
+#endif
+
+#if CONFIG_KJSON_STATS_CYCLES
+#define STATS_FITS(jsonHandle)   CountCycles((jsonHandle), &(jsonHandle)->stats.fitsCycles)
+#define STATS_FORMAT(jsonHandle) CountCycles((jsonHandle), &(jsonHandle)->stats.formatCycles)
+#else
+#define STATS_FITS(jsonHandle)
+#define STATS_FORMAT(jsonHandle)
+#endif
+
 //------------------------------------------------------------------------------
 // External variables
 //------------------------------------------------------------------------------
@@ -89,665 +145,4549 @@ typedef enum
 {
    eUnsigned = 0,
    eSigned = 1,
+   eUnsigned64 = 2,
+   eSigned64 = 3,
+   eUnsigned8 = 4,
+   eSigned8 = 5,
+   eUnsigned16 = 6,
+   eSigned16 = 7,
+   eUnsigned32 = 8,
+   eSigned32 = 9,
 } NumberType_e;
 
+typedef enum
+{
+   eBase64 = 0,
+   eHex = 1,
+} BinaryType_e;
+
+typedef struct
+{
+   char *const buffer;      // Buffer to store the output, NULL to only measure it
+   const size_t bufferSize; // Size of the buffer
+   size_t size;             // Size of the output, also counted past the end of the buffer
+} Output_t;
+
+typedef struct
+{
+   const char *const json; // Input of the reformatter
+   const size_t length;    // Length of the input
+   size_t base;            // Start of the classified window
+   uint64_t structural;    // '"', brackets, ',', ':' and whitespace in the window, one bit per byte
+   uint64_t quotes;        // '"' and '\\' in the window, one bit per byte
+} Scanner_t;
+
+#if !CONFIG_KJSON_NO_FLOAT
+typedef enum
+{
+   eFloat = 0,
+   eDouble = 1,
+} FloatType_e;
+
+typedef struct
+{
+   uint64_t integer;      // Integer part, if the magnitude is below 2^64
+   uint64_t mantissa;     // Mantissa of magnitudes of 2^64 and above
+   int exponent;          // Binary exponent of the mantissa (0 if not used), or the shortest power of 10
+   uint32_t fraction;     // Rounded fractional part, scaled by 10^decimals
+   unsigned int decimals; // Number of decimals to output
+   char digits[17];       // Shortest round trip digits
+   size_t count;          // Number of shortest round trip digits
+   bool negative;         // Sign of the value
+   bool shortest;         // Value is held as the shortest round trip digits
+} DecimalFloat_t;
+
+#endif
+
 //------------------------------------------------------------------------------
 // Module static variables
 //------------------------------------------------------------------------------
+static const char digitPairs[] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static const char base64Digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                   "abcdefghijklmnopqrstuvwxyz"
+                                   "0123456789+/";
+
+// Character following the backslash for control characters, 'u' for \u00XX
+static const char escapeCodes[] = "uuuuuuuubtnufruu"
+                                  "uuuuuuuuuuuuuuuu";
+
+static const uint64_t powersOf10[] = {
+   1ull,
+   10ull,
+   100ull,
+   1000ull,
+   10000ull,
+   100000ull,
+   1000000ull,
+   10000000ull,
+   100000000ull,
+   1000000000ull,
+   10000000000ull,
+   100000000000ull,
+   1000000000000ull,
+   10000000000000ull,
+   100000000000000ull,
+   1000000000000000ull,
+   10000000000000000ull,
+   100000000000000000ull,
+   1000000000000000000ull,
+   10000000000000000000ull,
+};
+
+#if KJSON_SSE2
+// 10^i - 1 for i = 1 to 9, biased by 2^31 for signed compares
+static const int32_t digitThresholds[] = {
+   (int32_t)(9u ^ 0x80000000u),
+   (int32_t)(99u ^ 0x80000000u),
+   (int32_t)(999u ^ 0x80000000u),
+   (int32_t)(9999u ^ 0x80000000u),
+   (int32_t)(99999u ^ 0x80000000u),
+   (int32_t)(999999u ^ 0x80000000u),
+   (int32_t)(9999999u ^ 0x80000000u),
+   (int32_t)(99999999u ^ 0x80000000u),
+   (int32_t)(999999999u ^ 0x80000000u),
+};
+#endif
+
+#if !CONFIG_KJSON_NO_FLOAT
+// floor(2^(bits(5^i) - 1 + FLOAT_POW5_INV_BITCOUNT) / 5^i) + 1
+static const uint64_t floatPow5InvSplit[] = {
+   0x0800000000000001ull, 0x0666666666666667ull, 0x051EB851EB851EB9ull,
+   0x04189374BC6A7EFAull, 0x068DB8BAC710CB2Aull, 0x053E2D6238DA3C22ull,
+   0x0431BDE82D7B634Eull, 0x06B5FCA6AF2BD216ull, 0x055E63B88C230E78ull,
+   0x044B82FA09B5A52Dull, 0x06DF37F675EF6EAEull, 0x057F5FF85E592558ull,
+   0x0465E6604B7A8447ull, 0x0709709A125DA071ull, 0x05A126E1A84AE6C1ull,
+   0x0480EBE7B9D58567ull, 0x0734ACA5F6226F0Bull, 0x05C3BD5191B525A3ull,
+   0x049C97747490EAE9ull, 0x0760F253EDB4AB0Eull, 0x05E72843249088D8ull,
+   0x04B8ED0283A6D3E0ull, 0x078E480405D7B966ull, 0x060B6CD004AC9452ull,
+   0x04D5F0A66A23A9DBull, 0x07BCB43D769F762Bull, 0x063090312BB2C4EFull,
+   0x04F3A68DBC8F03F3ull, 0x07EC3DAF94180651ull, 0x065697BFA9ACD1DAull,
+   0x051212FFBAF0A7E2ull,
+};
+
+// 5^i truncated to FLOAT_POW5_BITCOUNT bits
+static const uint64_t floatPow5Split[] = {
+   0x1000000000000000ull, 0x1400000000000000ull, 0x1900000000000000ull,
+   0x1F40000000000000ull, 0x1388000000000000ull, 0x186A000000000000ull,
+   0x1E84800000000000ull, 0x1312D00000000000ull, 0x17D7840000000000ull,
+   0x1DCD650000000000ull, 0x12A05F2000000000ull, 0x174876E800000000ull,
+   0x1D1A94A200000000ull, 0x12309CE540000000ull, 0x16BCC41E90000000ull,
+   0x1C6BF52634000000ull, 0x11C37937E0800000ull, 0x16345785D8A00000ull,
+   0x1BC16D674EC80000ull, 0x1158E460913D0000ull, 0x15AF1D78B58C4000ull,
+   0x1B1AE4D6E2EF5000ull, 0x10F0CF064DD59200ull, 0x152D02C7E14AF680ull,
+   0x1A784379D99DB420ull, 0x108B2A2C28029094ull, 0x14ADF4B7320334B9ull,
+   0x19D971E4FE8401E7ull, 0x1027E72F1F128130ull, 0x1431E0FAE6D7217Cull,
+   0x193E5939A08CE9DBull, 0x1F8DEF8808B02452ull, 0x13B8B5B5056E16B3ull,
+   0x18A6E32246C99C60ull, 0x1ED09BEAD87C0378ull, 0x13426172C74D822Bull,
+   0x1812F9CF7920E2B6ull, 0x1E17B84357691B64ull, 0x12CED32A16A1B11Eull,
+   0x178287F49C4A1D66ull, 0x1D6329F1C35CA4BFull, 0x125DFA371A19E6F7ull,
+   0x16F578C4E0A060B5ull, 0x1CB2D6F618C878E3ull, 0x11EFC659CF7D4B8Dull,
+   0x166BB7F0435C9E71ull, 0x1C06A5EC5433C60Dull,
+};
+
+// 5^i for i < DOUBLE_POW5_TABLE_SIZE, the step between the entries of the split tables below
+static const uint64_t doublePow5Table[] = {
+   0x0000000000000001ull, 0x0000000000000005ull, 0x0000000000000019ull,
+   0x000000000000007Dull, 0x0000000000000271ull, 0x0000000000000C35ull,
+   0x0000000000003D09ull, 0x000000000001312Dull, 0x000000000005F5E1ull,
+   0x00000000001DCD65ull, 0x00000000009502F9ull, 0x0000000002E90EDDull,
+   0x000000000E8D4A51ull, 0x0000000048C27395ull, 0x000000016BCC41E9ull,
+   0x000000071AFD498Dull, 0x0000002386F26FC1ull, 0x000000B1A2BC2EC5ull,
+   0x000003782DACE9D9ull, 0x00001158E460913Dull, 0x000056BC75E2D631ull,
+   0x0001B1AE4D6E2EF5ull, 0x000878678326EAC9ull, 0x002A5A058FC295EDull,
+   0x00D3C21BCECCEDA1ull, 0x0422CA8B0A00A425ull,
+};
+
+// 5^i truncated to DOUBLE_POW5_BITCOUNT bits, low then high word, every DOUBLE_POW5_TABLE_SIZE
+static const uint64_t doublePow5Split[][2] = {
+   {0x0000000000000000ull, 0x1000000000000000ull},
+   {0x0000000000000000ull, 0x14ADF4B7320334B9ull},
+   {0x0E549208B31ADB10ull, 0x1ABA4714957D300Dull},
+   {0x6DC6AD264D8F0866ull, 0x1145B7E285BF98F5ull},
+   {0xEB1DBD923D8596CAull, 0x1652EFDC6018A1FCull},
+   {0xB4C1B80B22AE923Cull, 0x1CDA62055B2D9D83ull},
+   {0x5BB28B4E8F7E4C30ull, 0x12A5568B9F52F416ull},
+   {0xF08AED437682D4FBull, 0x1819651531F9E78Full},
+   {0xB4EE134AD99BF150ull, 0x1F25C186A6F04C28ull},
+   {0x16499ECB70C25F03ull, 0x1420EB449C8842E6ull},
+   {0x85A56EAD360865B0ull, 0x1A03FDE214CAF085ull},
+   {0x093DB1D57999890Bull, 0x10CFEB353A97DAD8ull},
+   {0xCF38BB735E3F36ACull, 0x15BAAF44FA52673Eull},
+};
+
+// Error of 5^i computed from doublePow5Split, 2 bits for each i
+static const uint32_t doublePow5Offsets[] = {
+   0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u,
+   0x40000000u, 0x59695995u, 0x55545555u, 0x56555515u,
+   0x41150504u, 0x40555410u, 0x44555145u, 0x44504540u,
+   0x45555550u, 0x40004000u, 0x96440440u, 0x55565565u,
+   0x54454045u, 0x40154151u, 0x55559155u, 0x51405555u,
+   0x00000105u,
+};
+
+// floor(2^(bits(5^i) - 1 + DOUBLE_POW5_INV_BITCOUNT) / 5^i), low then high word, every DOUBLE_POW5_TABLE_SIZE
+static const uint64_t doublePow5InvSplit[][2] = {
+   {0x0000000000000000ull, 0x2000000000000000ull},
+   {0x52A6C95FC0655033ull, 0x18C240C4AECB13BBull},
+   {0x7CA8D50071DFC805ull, 0x1327FC58DA0F6FF5ull},
+   {0x6520247D3556476Dull, 0x1DA48CE468E7C702ull},
+   {0x6139CDD76802E6E8ull, 0x16EF5B40C2FC7779ull},
+   {0xF951A7FF43DE8C78ull, 0x11BEBDF578B2F391ull},
+   {0x7BE8BEE8D6E957E7ull, 0x1B758D848FAC54B0ull},
+   {0x8BD3F9E999A423E9ull, 0x153EDA614071A3B7ull},
+   {0x0848F973CB3EE3CDull, 0x10701BD527B4978Cull},
+   {0x153285EBB9EFBFA1ull, 0x196FBB9BB44DB44Dull},
+   {0xADEEE7F86C07B695ull, 0x13AE3591F5B4D936ull},
+   {0x4D686A4EAF182221ull, 0x1E74404F3DAADA91ull},
+   {0x98C0A106E09EBD9Eull, 0x17900EA4FDA7C257ull},
+};
+
+// Error of the inverse of 5^i computed from doublePow5InvSplit, 2 bits for each i
+static const uint32_t doublePow5InvOffsets[] = {
+   0x54544554u, 0x04055545u, 0x10041000u, 0x00400414u,
+   0x40010000u, 0x41155555u, 0x00000454u, 0x00010044u,
+   0x40000000u, 0x44000041u, 0x50454450u, 0x55550054u,
+   0x51655554u, 0x40004000u, 0x01000001u, 0x00010500u,
+   0x51515411u, 0x05555554u, 0x00000000u,
+};
+#endif
+
+static const size_t numberSizes[] = {
+   sizeof(unsigned int),
+   sizeof(int),
+   sizeof(uint64_t),
+   sizeof(int64_t),
+   sizeof(uint8_t),
+   sizeof(int8_t),
+   sizeof(uint16_t),
+   sizeof(int16_t),
+   sizeof(uint32_t),
+   sizeof(int32_t),
+};
 
 //------------------------------------------------------------------------------
 // Module static function prototypes
 //------------------------------------------------------------------------------
-static size_t InsertString(char *const string, const char *const key, const char *const value);
-static size_t InsertNumber(char *const string, const char *const key, const int value);
-static size_t InsertUnsignedNumber(char *const string, const char *const key, const unsigned int value);
+static size_t InsertString(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const char *const value);
+static KJSON_OUTLINE void CommitString(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const value);
+static KJSON_INLINE size_t InsertNumber(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key, const void *const value, const NumberType_e type, const size_t length);
 #if !CONFIG_KJSON_NO_FLOAT
-static size_t InsertFloat(char *const string, const char *const key, const float value, const unsigned int decimals);
+static size_t InsertFloat(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key, const DecimalFloat_t *const value);
 #endif
-static size_t InsertBoolean(char *const string, const char *const key, bool value);
-static size_t InsertNull(char *const string, const char *const key);
+static KJSON_INLINE size_t InsertBoolean(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key, bool value);
+static KJSON_INLINE size_t InsertNull(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key);
 
-static size_t InsertArrayNumber(char *const string, const char *const key, const void *const array, const size_t size, const NumberType_e type, void *const nullValue);
-static size_t InsertArrayString(char *const string, const char *const key, const char *const *const array, const size_t size);
+static size_t InsertArrayNumber(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const void *const array, const size_t size, const NumberType_e type, const void *const nullValue);
+static size_t InsertArrayString(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const char *const *const array, const size_t size);
 #if !CONFIG_KJSON_NO_FLOAT
-static size_t InsertArrayFloat(char *const string, const char *const key, const float *const array, const size_t size, const unsigned int decimals, const float nullValue);
+static size_t InsertArrayFloat(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const void *const array, const size_t size, const FloatType_e type, const unsigned int decimals, const void *const nullValue);
 #endif
+static size_t InsertSlot(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key);
+static size_t WriteSlot(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_slot_t *const slot, const kjson_value_t *const value);
+static size_t GetSlotCount(const kjson_template_t *const templateHandle);
+static size_t WriteNull(char *const string, const size_t space);
 
 static size_t InitRoot(char *const string);
 static size_t Trim(char *const string);
 static size_t ExitRoot(char *const string);
-static size_t EnterObject(char *const string, const char *const key);
+static size_t EnterObject(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key);
 static size_t ExitObject(char *const string);
-static size_t EnterArray(char *const string, const char *const key);
+static size_t EnterArray(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key);
 static size_t ExitArray(char *const string);
-static size_t InsertDepth(char *const string, const char *const newLine, const int depth);
+static size_t InsertLine(const kjson_t *const jsonHandle, char *const string);
+static size_t InsertKeySeparator(const kjson_t *const jsonHandle, char *const string);
+static KJSON_INLINE size_t InsertKey(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key);
+static size_t WriteKey(const kjson_t *const jsonHandle, char *const string, const size_t space, const char *const key, const size_t separator);
+static size_t InsertPrefix(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key);
+static size_t InsertArraySeparator(char *const string, const size_t separator);
+static size_t InsertArrayEnd(char *const start, char *end, const char *const limit, const size_t size, const size_t separator);
+static size_t InsertBinary(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const uint8_t *const data, const size_t length, const BinaryType_e type);
+static size_t InsertArrayBinary(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size, const BinaryType_e type);
+static size_t InsertRaw(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const char *const json, const size_t length);
+static size_t InsertQuoted(const kjson_t *const jsonHandle, char *const string, const size_t space, const char *const value);
+static size_t InsertValue(const kjson_t *const jsonHandle, char *const string, const size_t space, const char *const value);
+static size_t GetPrefixLength(const kjson_t *const jsonHandle, const kjson_key_t *const key);
+static size_t GetArrayLength(const kjson_t *const jsonHandle, const size_t length, const size_t size);
+static size_t GetLineLength(const kjson_t *const jsonHandle);
+static size_t GetIndentLength(const kjson_t *const jsonHandle);
+static size_t GetKeySeparatorLength(const kjson_t *const jsonHandle);
+static size_t GetArraySeparatorLength(const kjson_t *const jsonHandle);
+static void SetFormat(kjson_t *const jsonHandle);
+static size_t MeasureString(const kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const value);
+static size_t MeasureArrayNumber(const kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const array, const size_t size, const NumberType_e type, const void *const nullValue);
+static size_t MeasureArrayString(const kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const *const array, const size_t size);
+static size_t MeasureBinary(const kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t length, const BinaryType_e type);
+static size_t MeasureArrayBinary(const kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size, const BinaryType_e type);
+static size_t MeasureRaw(const kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t length);
+#if !CONFIG_KJSON_NO_FLOAT
+static size_t MeasureArrayFloat(const kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const array, const size_t size, const FloatType_e type, const unsigned int decimals, const void *const nullValue);
+#endif
+static size_t CountLines(const char *const string, const size_t length);
+static size_t WriteFragment(const kjson_t *const jsonHandle, char *const string, const char *const fragment, const size_t length);
 static void StartEntry(kjson_t *const jsonHandle);
+static void StartLine(kjson_t *const jsonHandle);
+static size_t GetSpare(const kjson_t *const jsonHandle);
+static size_t GetSpace(const kjson_t *const jsonHandle);
+static void CommitEntry(kjson_t *const jsonHandle, const size_t bytes);
+static bool Flush(kjson_t *const jsonHandle);
+static bool Reserve(kjson_t *const jsonHandle, const size_t size);
+static bool Measure(kjson_t *const jsonHandle, const size_t size);
+static void DropReferences(kjson_t *const jsonHandle);
+static void EndRecord(kjson_t *const jsonHandle);
+#if CONFIG_KJSON_STATS
+static void CountInsert(kjson_t *const jsonHandle, const kjson_stat_e type);
+static void CountTruncation(kjson_t *const jsonHandle, const size_t size);
+static void CountShortfall(kjson_t *const jsonHandle, const size_t size);
+static void CountCommit(kjson_t *const jsonHandle, const size_t needed);
+static void CountPeak(kjson_t *const jsonHandle, const size_t size);
+static void CountOutput(kjson_t *const jsonHandle);
+#endif
+#if CONFIG_KJSON_STATS_CYCLES
+static void CountCycles(kjson_t *const jsonHandle, uint64_t *const cycles);
+#endif
 
-static size_t GetNumDigits(const void *const value, const NumberType_e type);
-static bool StringFits(kjson_t *const jsonHandle, const char *const key, const char *const value);
-static bool NumberFits(kjson_t *const jsonHandle, const char *const key, const void *const value, const NumberType_e type);
-#if !CONFIG_KJSON_NO_FLOAT
-static bool FloatFits(kjson_t *const jsonHandle, const char *const key, const float value, const unsigned int decimals);
+static size_t WriteUnsigned(char *const string, uint32_t value, const size_t length);
+static size_t WriteSigned(char *const string, const int value, const size_t length);
+static size_t WriteUnsigned64(char *const string, uint64_t value, const size_t length);
+static size_t WriteSigned64(char *const string, const int64_t value, const size_t length);
+static size_t WriteNumber(char *const string, const void *const value, const NumberType_e type, const size_t length);
+static size_t GetNumDigits(const uint32_t value);
+static size_t GetNumDigits64(const uint64_t value);
+static size_t GetNumLength(const void *const value, const NumberType_e type);
+static bool IsNumberNull(const void *const value, const NumberType_e type, const void *const nullValue);
+static size_t GetNumLengths(const void *const array, const size_t size, const NumberType_e type, const void *const nullValue, uint8_t *const lengths);
+#if KJSON_SSE2
+static __m128i LoadLanes4(const char *const value, const NumberType_e type);
+static __m128i CountDigits4(const __m128i lanes, const bool isSigned);
+#endif
+#if KJSON_AVX2
+static __m256i LoadLanes8(const char *const value, const NumberType_e type);
+static __m256i CountDigits8(const __m256i lanes, const bool isSigned);
+#endif
+static int32_t LoadSigned(const void *const value, const NumberType_e type);
+static uint32_t LoadUnsigned(const void *const value, const NumberType_e type);
+static size_t FindEscape(const char *const string, const size_t length, const bool ascii);
+static void ScanWindow(Scanner_t *const scanner, const size_t base);
+static size_t FindNext(Scanner_t *const scanner, size_t i, const bool inString);
+static size_t SkipString(Scanner_t *const scanner, size_t i);
+static bool IsInlineArray(Scanner_t *const scanner, size_t i);
+static void Emit(Output_t *const output, const char *const data, const size_t length);
+static void EmitLine(Output_t *const output, const char *const newLine, const size_t newLineLength, const size_t depth);
+static size_t EndOutput(Output_t *const output);
+#if !CONFIG_KJSON_NO_RAW_CHECK
+static bool CheckRaw(const char *const json, const size_t length, const bool ascii);
+#endif
+static size_t DecodeUtf8(const char *const string, const size_t length, uint32_t *const codePoint);
+static size_t WriteUnicodeEscape(char *const string, const uint32_t unit);
+static size_t WriteEscaped(char *const string, size_t space, const char *const value, const kjson_ascii_e ascii);
+static size_t WriteBinary(char *const string, const uint8_t *const data, const size_t length, const BinaryType_e type);
+static size_t WriteBase64(char *const string, const uint8_t *const data, const size_t length);
+#if KJSON_SSSE3
+static __m128i EncodeBase64Block16(const __m128i bytes);
 #endif
-static bool BooleanFits(kjson_t *const jsonHandle, const char *const key, bool value);
-static bool NullFits(kjson_t *const jsonHandle, const char *const key);
-static bool ArrayNumberFits(kjson_t *const jsonHandle, const char *const key, const void *const array, const size_t size, const NumberType_e type);
+#if KJSON_AVX2
+static __m256i EncodeBase64Block32(const __m256i bytes);
+#endif
+static size_t WriteHex(char *const string, const uint8_t *const data, const size_t length);
+#if KJSON_SSE2
+static __m128i GetHexDigits16(const __m128i nibbles);
+#endif
+static size_t GetBinaryLength(const size_t length, const BinaryType_e type);
+static size_t GetEscapedLength(const char *const value, const kjson_ascii_e ascii);
+static size_t GetStringLength(kjson_t *const jsonHandle, const char *const value);
+static size_t GetKeyLength(kjson_t *const jsonHandle, const kjson_key_t *const key);
+static size_t GetEntryLength(kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t valueSize);
+static bool NumberFits(kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t valueSize);
 #if !CONFIG_KJSON_NO_FLOAT
-static bool ArrayFloatFits(kjson_t *const jsonHandle, const char *const key, const float *const array, const size_t size, const unsigned int decimals);
+static bool IsFloatFinite(const float value);
+static bool IsDoubleFinite(const double value);
+static bool IsDoubleNull(const double value, const double nullValue);
+static bool SplitValue(const void *const value, const FloatType_e type, const unsigned int decimals, const void *const nullValue, DecimalFloat_t *const decimal);
+static void SplitFloat(const float value, const unsigned int decimals, DecimalFloat_t *const decimal);
+static void SplitDouble(const double value, const unsigned int decimals, DecimalFloat_t *const decimal);
+static void SplitFraction(const uint64_t mantissa, const unsigned int shift, DecimalFloat_t *const decimal);
+static uint64_t Multiply64(const uint64_t a, const uint64_t b, uint64_t *const high);
+static size_t WriteLargeInteger(char *const string, const uint64_t mantissa, const int exponent);
+static bool IsMultipleOfPow5(uint64_t value, const uint32_t q);
+static uint32_t MulShift32(const uint32_t value, const uint64_t factor, const int32_t shift);
+static int32_t Pow5Bits(const int32_t exponent);
+static void ShortestFloat(const uint32_t bits, DecimalFloat_t *const decimal);
+static void ComputePow5(const uint32_t i, uint64_t *const result);
+static void ComputeInvPow5(const uint32_t i, uint64_t *const result);
+static uint64_t MulShift64(const uint64_t value, const uint64_t *const factor, const int32_t shift);
+static void ShortestDouble(const uint64_t mantissa, const int exponent, DecimalFloat_t *const decimal);
+static size_t WriteShortest(char *const string, const DecimalFloat_t *const decimal);
+static size_t GetShortestLength(const DecimalFloat_t *const decimal);
+static size_t WriteFloat(char *const string, const DecimalFloat_t *const decimal);
+static size_t GetFloatLength(const DecimalFloat_t *const decimal);
+static bool FloatFits(kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t valueSize);
 #endif
-static bool ArrayStringFits(kjson_t *const jsonHandle, const char *const key, const char *const *const array, const size_t size);
-static bool ObjectFits(kjson_t *const jsonHandle, const char *const key);
+static bool BooleanFits(kjson_t *const jsonHandle, const kjson_key_t *const key, bool value);
+static bool NullFits(kjson_t *const jsonHandle, const kjson_key_t *const key);
+static bool ObjectFits(kjson_t *const jsonHandle, const kjson_key_t *const key);
 
 //------------------------------------------------------------------------------
 // Module externally exported functions
 //------------------------------------------------------------------------------
+bool kJSON_PrepareKey(kjson_key_t *const keyHandle, char *const buffer, const size_t bufferSize, const char *const key, const kjson_ascii_e ascii)
+{
+   const size_t length = GetEscapedLength(key, ascii);
+   const size_t size = char_size("\"") + length + char_size(KEY_END);
+   if ((REJECTED_LENGTH == length) || (size >= bufferSize))
+   {
+      return false;
+   }
+   char *end = buffer;
+   *(end++) = '"';
+   end += WriteEscaped(end, NO_FIT, key, ascii);
+   memcpy(end, KEY_END, char_size(KEY_END));
+   end += char_size(KEY_END);
+   *end = '\0';
+   keyHandle->text = buffer;
+   keyHandle->length = size;
+   return true;
+}
+
 void kJSON_InsertString(kjson_t *const jsonHandle, const char *const key, const char *const value)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertStringWithKey(jsonHandle, &name, value);
+}
+
+void kJSON_InsertStringWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const value)
 {
    if (NULL == value)
    {
-      kJSON_InsertNull(jsonHandle, key);
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      if (StringFits(jsonHandle, key, value))
-      {
-         StartEntry(jsonHandle);
-         const size_t bytes = InsertString(jsonHandle->tail, key, value);
-         jsonHandle->size += bytes;
-         jsonHandle->tail += bytes;
-      }
-      else
-      {
-         jsonHandle->truncated = true;
-      }
+      STATS_INSERT(jsonHandle, KJSON_STAT_STRING);
+      CommitString(jsonHandle, key, value);
    }
 }
 
 void kJSON_InsertNumber(kjson_t *const jsonHandle, const char *const key, const int value)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertNumberWithKey(jsonHandle, &name, value);
+}
+
+void kJSON_InsertNumberWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int value)
 {
    if (value == jsonHandle->nullIntValue)
    {
-      kJSON_InsertNull(jsonHandle, key);
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      if (NumberFits(jsonHandle, key, &value, eSigned))
+      STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+      const size_t length = GetNumLength(&value, eSigned);
+      if (!NumberFits(jsonHandle, key, length))
+      {
+         jsonHandle->truncated = true;
+      }
+      else if (jsonHandle->root)
       {
          StartEntry(jsonHandle);
-         const size_t bytes = InsertNumber(jsonHandle->tail, key, value);
+         const size_t bytes = InsertNumber(jsonHandle, jsonHandle->tail, key, &value, eSigned, length);
          jsonHandle->size += bytes;
          jsonHandle->tail += bytes;
-      }
-      else
-      {
-         jsonHandle->truncated = true;
+         STATS_FORMAT(jsonHandle);
       }
    }
 }
 
 void kJSON_InsertUnsignedNumber(kjson_t *const jsonHandle, const char *const key, const unsigned int value)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertUnsignedNumberWithKey(jsonHandle, &name, value);
+}
+
+void kJSON_InsertUnsignedNumberWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const unsigned int value)
 {
    if (value == jsonHandle->nullUIntValue)
    {
-      kJSON_InsertNull(jsonHandle, key);
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      if (NumberFits(jsonHandle, key, &value, eUnsigned))
+      STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+      const size_t length = GetNumLength(&value, eUnsigned);
+      if (!NumberFits(jsonHandle, key, length))
+      {
+         jsonHandle->truncated = true;
+      }
+      else if (jsonHandle->root)
       {
          StartEntry(jsonHandle);
-         const size_t bytes = InsertUnsignedNumber(jsonHandle->tail, key, value);
+         const size_t bytes = InsertNumber(jsonHandle, jsonHandle->tail, key, &value, eUnsigned, length);
          jsonHandle->size += bytes;
          jsonHandle->tail += bytes;
-      }
-      else
-      {
-         jsonHandle->truncated = true;
+         STATS_FORMAT(jsonHandle);
       }
    }
 }
 
-#if !CONFIG_KJSON_NO_FLOAT
-void kJSON_InsertFloat(kjson_t *const jsonHandle, const char *const key, const float value, const unsigned int decimals)
+void kJSON_InsertNumber64(kjson_t *const jsonHandle, const char *const key, const int64_t value)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertNumber64WithKey(jsonHandle, &name, value);
+}
+
+void kJSON_InsertNumber64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int64_t value)
 {
-   if (IS_FLOAT_NULL(value, jsonHandle->nullFloatValue))
+   if (value == jsonHandle->nullInt64Value)
    {
-      kJSON_InsertNull(jsonHandle, key);
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      if (FloatFits(jsonHandle, key, value, decimals))
+      STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+      const size_t length = GetNumLength(&value, eSigned64);
+      if (!NumberFits(jsonHandle, key, length))
+      {
+         jsonHandle->truncated = true;
+      }
+      else if (jsonHandle->root)
       {
          StartEntry(jsonHandle);
-         const size_t bytes = InsertFloat(jsonHandle->tail, key, value, decimals);
+         const size_t bytes = InsertNumber(jsonHandle, jsonHandle->tail, key, &value, eSigned64, length);
          jsonHandle->size += bytes;
          jsonHandle->tail += bytes;
-      }
-      else
-      {
-         jsonHandle->truncated = true;
+         STATS_FORMAT(jsonHandle);
       }
    }
 }
-#endif // CONFIG_KJSON_NO_FLOAT
 
-void kJSON_InsertBoolean(kjson_t *const jsonHandle, const char *const key, bool value)
+void kJSON_InsertUnsignedNumber64(kjson_t *const jsonHandle, const char *const key, const uint64_t value)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertUnsignedNumber64WithKey(jsonHandle, &name, value);
+}
+
+void kJSON_InsertUnsignedNumber64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint64_t value)
 {
-   if (BooleanFits(jsonHandle, key, value))
+   if (value == jsonHandle->nullUInt64Value)
    {
-      StartEntry(jsonHandle);
-      const size_t bytes = InsertBoolean(jsonHandle->tail, key, value);
-      jsonHandle->size += bytes;
-      jsonHandle->tail += bytes;
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      jsonHandle->truncated = true;
+      STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+      const size_t length = GetNumLength(&value, eUnsigned64);
+      if (!NumberFits(jsonHandle, key, length))
+      {
+         jsonHandle->truncated = true;
+      }
+      else if (jsonHandle->root)
+      {
+         StartEntry(jsonHandle);
+         const size_t bytes = InsertNumber(jsonHandle, jsonHandle->tail, key, &value, eUnsigned64, length);
+         jsonHandle->size += bytes;
+         jsonHandle->tail += bytes;
+         STATS_FORMAT(jsonHandle);
+      }
    }
 }
 
-void kJSON_InsertNull(kjson_t *const jsonHandle, const char *const key)
+#if !CONFIG_KJSON_NO_FLOAT
+void kJSON_InsertFloat(kjson_t *const jsonHandle, const char *const key, const float value, const unsigned int decimals)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertFloatWithKey(jsonHandle, &name, value, decimals);
+}
+
+void kJSON_InsertFloatWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const float value, const unsigned int decimals)
 {
-   if (NullFits(jsonHandle, key))
+   DecimalFloat_t decimal;
+   if (!SplitValue(&value, eFloat, decimals, &jsonHandle->nullFloatValue, &decimal))
    {
-      StartEntry(jsonHandle);
-      const size_t bytes = InsertNull(jsonHandle->tail, key);
-      jsonHandle->size += bytes;
-      jsonHandle->tail += bytes;
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      jsonHandle->truncated = true;
+      STATS_INSERT(jsonHandle, KJSON_STAT_FLOAT);
+      if (!FloatFits(jsonHandle, key, GetFloatLength(&decimal)))
+      {
+         jsonHandle->truncated = true;
+      }
+      else if (jsonHandle->root)
+      {
+         StartEntry(jsonHandle);
+         const size_t bytes = InsertFloat(jsonHandle, jsonHandle->tail, key, &decimal);
+         jsonHandle->size += bytes;
+         jsonHandle->tail += bytes;
+         STATS_FORMAT(jsonHandle);
+      }
    }
 }
 
-void kJSON_InsertArrayInt(kjson_t *const jsonHandle, const char *const key, const int *const array, const size_t size)
+void kJSON_InsertDouble(kjson_t *const jsonHandle, const char *const key, const double value, const unsigned int decimals)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertDoubleWithKey(jsonHandle, &name, value, decimals);
+}
+
+void kJSON_InsertDoubleWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const double value, const unsigned int decimals)
 {
-   if (ArrayNumberFits(jsonHandle, key, array, size, eSigned))
+   DecimalFloat_t decimal;
+   if (!SplitValue(&value, eDouble, decimals, &jsonHandle->nullDoubleValue, &decimal))
    {
-      StartEntry(jsonHandle);
-      const size_t bytes = InsertArrayNumber(jsonHandle->tail, key, array, size, eSigned, &jsonHandle->nullIntValue);
-      jsonHandle->size += bytes;
-      jsonHandle->tail += bytes;
+      kJSON_InsertNullWithKey(jsonHandle, key);
    }
    else
    {
-      jsonHandle->truncated = true;
+      STATS_INSERT(jsonHandle, KJSON_STAT_FLOAT);
+      if (!FloatFits(jsonHandle, key, GetFloatLength(&decimal)))
+      {
+         jsonHandle->truncated = true;
+      }
+      else if (jsonHandle->root)
+      {
+         StartEntry(jsonHandle);
+         const size_t bytes = InsertFloat(jsonHandle, jsonHandle->tail, key, &decimal);
+         jsonHandle->size += bytes;
+         jsonHandle->tail += bytes;
+         STATS_FORMAT(jsonHandle);
+      }
    }
 }
+#endif // CONFIG_KJSON_NO_FLOAT
 
-void kJSON_InsertArrayUInt(kjson_t *const jsonHandle, const char *const key, const unsigned int *const array, const size_t size)
+void kJSON_InsertBoolean(kjson_t *const jsonHandle, const char *const key, bool value)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertBooleanWithKey(jsonHandle, &name, value);
+}
+
+void kJSON_InsertBooleanWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, bool value)
 {
-   if (ArrayNumberFits(jsonHandle, key, array, size, eUnsigned))
+   STATS_INSERT(jsonHandle, KJSON_STAT_BOOLEAN);
+   if (!BooleanFits(jsonHandle, key, value))
+   {
+      jsonHandle->truncated = true;
+   }
+   else if (jsonHandle->root)
    {
       StartEntry(jsonHandle);
-      const size_t bytes = InsertArrayNumber(jsonHandle->tail, key, array, size, eUnsigned, &jsonHandle->nullUIntValue);
+      const size_t bytes = InsertBoolean(jsonHandle, jsonHandle->tail, key, value);
       jsonHandle->size += bytes;
       jsonHandle->tail += bytes;
-   }
-   else
-   {
-      jsonHandle->truncated = true;
+      STATS_FORMAT(jsonHandle);
    }
 }
 
-void kJSON_InsertArrayFloat(kjson_t *const jsonHandle, const char *const key, const float *const array, const size_t size, const unsigned int decimals)
+void kJSON_InsertNull(kjson_t *const jsonHandle, const char *const key)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertNullWithKey(jsonHandle, &name);
+}
+
+void kJSON_InsertNullWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key)
 {
-   if (ArrayFloatFits(jsonHandle, key, array, size, decimals))
+   STATS_INSERT(jsonHandle, KJSON_STAT_NULL);
+   if (!NullFits(jsonHandle, key))
+   {
+      jsonHandle->truncated = true;
+   }
+   else if (jsonHandle->root)
    {
       StartEntry(jsonHandle);
-      const size_t bytes = InsertArrayFloat(jsonHandle->tail, key, array, size, decimals, jsonHandle->nullFloatValue);
+      const size_t bytes = InsertNull(jsonHandle, jsonHandle->tail, key);
       jsonHandle->size += bytes;
       jsonHandle->tail += bytes;
-   }
-   else
-   {
-      jsonHandle->truncated = true;
+      STATS_FORMAT(jsonHandle);
    }
 }
 
-void kJSON_InsertArrayString(kjson_t *const jsonHandle, const char *const key, const char *const *const array, const size_t size)
+void kJSON_InsertArrayInt(kjson_t *const jsonHandle, const char *const key, const int *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayIntWithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayIntWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int *const array, const size_t size)
 {
-   if (ArrayStringFits(jsonHandle, key, array, size))
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned, &jsonHandle->nullIntValue);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      StartEntry(jsonHandle);
-      const size_t bytes = InsertArrayString(jsonHandle->tail, key, array, size);
-      jsonHandle->size += bytes;
-      jsonHandle->tail += bytes;
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned, &jsonHandle->nullIntValue);
    }
-   else
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eSigned, &jsonHandle->nullIntValue));
+}
+
+void kJSON_InsertArrayUInt(kjson_t *const jsonHandle, const char *const key, const unsigned int *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayUIntWithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayUIntWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const unsigned int *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned, &jsonHandle->nullUIntValue);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      jsonHandle->truncated = true;
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned, &jsonHandle->nullUIntValue);
    }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eUnsigned, &jsonHandle->nullUIntValue));
 }
 
-void kJSON_InitRoot(kjson_t *const jsonHandle)
+void kJSON_InsertArrayInt64(kjson_t *const jsonHandle, const char *const key, const int64_t *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayInt64WithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayInt64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int64_t *const array, const size_t size)
 {
-   if (!jsonHandle->newLine || CONFIG_KJSON_SMALLEST)
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned64, &jsonHandle->nullInt64Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      jsonHandle->newLine = "";
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned64, &jsonHandle->nullInt64Value);
    }
-   const size_t bytes = InitRoot(jsonHandle->tail);
-   jsonHandle->size += bytes;
-   jsonHandle->tail += bytes;
-   // Account for closing brace
-   jsonHandle->size += strlen(jsonHandle->newLine) + char_size("}");
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eSigned64, &jsonHandle->nullInt64Value));
 }
 
-void kJSON_ExitRoot(kjson_t *const jsonHandle)
+void kJSON_InsertArrayUInt64(kjson_t *const jsonHandle, const char *const key, const uint64_t *const array, const size_t size)
 {
-   const size_t trim = Trim(jsonHandle->tail);
-   jsonHandle->tail += trim;
-   StartEntry(jsonHandle);
-   const size_t bytes = ExitRoot(jsonHandle->tail);
-   jsonHandle->tail += bytes;
-   jsonHandle->size += trim;
-   jsonHandle->size -= strlen(jsonHandle->newLine);
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayUInt64WithKey(jsonHandle, &name, array, size);
 }
 
-void kJSON_EnterObject(kjson_t *const jsonHandle, const char *const key)
+void kJSON_InsertArrayUInt64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint64_t *const array, const size_t size)
 {
-   if (ObjectFits(jsonHandle, key))
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned64, &jsonHandle->nullUInt64Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      StartEntry(jsonHandle);
-      const size_t bytes = EnterObject(jsonHandle->tail, key);
-      jsonHandle->size += bytes;
-      jsonHandle->tail += bytes;
-      jsonHandle->size += strlen(jsonHandle->newLine) + jsonHandle->depth + (char_size(OBJECT_END) - 1);
-#if !CONFIG_KJSON_SMALLEST
-      jsonHandle->depth++;
-#endif
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned64, &jsonHandle->nullUInt64Value);
    }
-   else
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eUnsigned64, &jsonHandle->nullUInt64Value));
+}
+
+void kJSON_InsertArrayInt8(kjson_t *const jsonHandle, const char *const key, const int8_t *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayInt8WithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayInt8WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int8_t *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned8, &jsonHandle->nullInt8Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      jsonHandle->truncated = true;
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned8, &jsonHandle->nullInt8Value);
    }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eSigned8, &jsonHandle->nullInt8Value));
 }
 
-void kJSON_ExitObject(kjson_t *const jsonHandle)
+void kJSON_InsertArrayUInt8(kjson_t *const jsonHandle, const char *const key, const uint8_t *const array, const size_t size)
 {
-   size_t bytes = Trim(jsonHandle->tail);
-   jsonHandle->tail += bytes;
-#if !CONFIG_KJSON_SMALLEST
-   jsonHandle->depth--;
-#endif
-   StartEntry(jsonHandle);
-   bytes = ExitObject(jsonHandle->tail);
-   jsonHandle->tail += bytes;
-   jsonHandle->size -= strlen(jsonHandle->newLine) + jsonHandle->depth;
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayUInt8WithKey(jsonHandle, &name, array, size);
 }
 
-void kJSON_EnterArray(kjson_t *const jsonHandle, const char *const key)
+void kJSON_InsertArrayUInt8WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint8_t *const array, const size_t size)
 {
-   if (ObjectFits(jsonHandle, key))
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned8, &jsonHandle->nullUInt8Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      StartEntry(jsonHandle);
-      const size_t bytes = EnterArray(jsonHandle->tail, key);
-      jsonHandle->size += bytes;
-      jsonHandle->tail += bytes;
-      jsonHandle->size += strlen(jsonHandle->newLine) + jsonHandle->depth + (char_size(ARRAY_END) - 1);
-#if !CONFIG_KJSON_SMALLEST
-      jsonHandle->depth++;
-#endif
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned8, &jsonHandle->nullUInt8Value);
    }
-   else
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eUnsigned8, &jsonHandle->nullUInt8Value));
+}
+
+void kJSON_InsertArrayInt16(kjson_t *const jsonHandle, const char *const key, const int16_t *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayInt16WithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayInt16WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int16_t *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned16, &jsonHandle->nullInt16Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
    {
-      jsonHandle->truncated = true;
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned16, &jsonHandle->nullInt16Value);
    }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eSigned16, &jsonHandle->nullInt16Value));
 }
 
-void kJSON_ExitArray(kjson_t *const jsonHandle)
+void kJSON_InsertArrayUInt16(kjson_t *const jsonHandle, const char *const key, const uint16_t *const array, const size_t size)
 {
-   size_t bytes = Trim(jsonHandle->tail);
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayUInt16WithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayUInt16WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint16_t *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned16, &jsonHandle->nullUInt16Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned16, &jsonHandle->nullUInt16Value);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eUnsigned16, &jsonHandle->nullUInt16Value));
+}
+
+void kJSON_InsertArrayInt32(kjson_t *const jsonHandle, const char *const key, const int32_t *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayInt32WithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayInt32WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int32_t *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned32, &jsonHandle->nullInt32Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eSigned32, &jsonHandle->nullInt32Value);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eSigned32, &jsonHandle->nullInt32Value));
+}
+
+void kJSON_InsertArrayUInt32(kjson_t *const jsonHandle, const char *const key, const uint32_t *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayUInt32WithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayUInt32WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint32_t *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_NUMBER);
+   size_t bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned32, &jsonHandle->nullUInt32Value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayNumber(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eUnsigned32, &jsonHandle->nullUInt32Value);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayNumber(jsonHandle, NULL, 0, key, array, size, eUnsigned32, &jsonHandle->nullUInt32Value));
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+void kJSON_InsertArrayFloat(kjson_t *const jsonHandle, const char *const key, const float *const array, const size_t size, const unsigned int decimals)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayFloatWithKey(jsonHandle, &name, array, size, decimals);
+}
+
+void kJSON_InsertArrayFloatWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const float *const array, const size_t size, const unsigned int decimals)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_FLOAT);
+   size_t bytes = InsertArrayFloat(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eFloat, decimals, &jsonHandle->nullFloatValue);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayFloat(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eFloat, decimals, &jsonHandle->nullFloatValue);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayFloat(jsonHandle, NULL, 0, key, array, size, eFloat, decimals, &jsonHandle->nullFloatValue));
+}
+
+void kJSON_InsertArrayDouble(kjson_t *const jsonHandle, const char *const key, const double *const array, const size_t size, const unsigned int decimals)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayDoubleWithKey(jsonHandle, &name, array, size, decimals);
+}
+
+void kJSON_InsertArrayDoubleWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const double *const array, const size_t size, const unsigned int decimals)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_FLOAT);
+   size_t bytes = InsertArrayFloat(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eDouble, decimals, &jsonHandle->nullDoubleValue);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayFloat(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size, eDouble, decimals, &jsonHandle->nullDoubleValue);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayFloat(jsonHandle, NULL, 0, key, array, size, eDouble, decimals, &jsonHandle->nullDoubleValue));
+}
+#endif // CONFIG_KJSON_NO_FLOAT
+
+void kJSON_InsertArrayString(kjson_t *const jsonHandle, const char *const key, const char *const *const array, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayStringWithKey(jsonHandle, &name, array, size);
+}
+
+void kJSON_InsertArrayStringWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const *const array, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_STRING);
+   size_t bytes = InsertArrayString(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayString(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, size);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayString(jsonHandle, NULL, 0, key, array, size));
+}
+
+void kJSON_InsertBase64(kjson_t *const jsonHandle, const char *const key, const void *const data, const size_t length)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertBase64WithKey(jsonHandle, &name, data, length);
+}
+
+void kJSON_InsertBase64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const data, const size_t length)
+{
+   if (NULL == data)
+   {
+      kJSON_InsertNullWithKey(jsonHandle, key);
+   }
+   else
+   {
+      STATS_INSERT(jsonHandle, KJSON_STAT_BINARY);
+      size_t bytes = InsertBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, (const uint8_t *)data, length, eBase64);
+      if ((NO_FIT == bytes) && Flush(jsonHandle))
+      {
+         bytes = InsertBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, (const uint8_t *)data, length, eBase64);
+      }
+      CommitEntry(jsonHandle, bytes);
+      STATS_COMMIT(jsonHandle, bytes, InsertBinary(jsonHandle, NULL, 0, key, data, length, eBase64));
+   }
+}
+
+void kJSON_InsertArrayBase64(kjson_t *const jsonHandle, const char *const key, const void *const *const array, const size_t *const lengths, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayBase64WithKey(jsonHandle, &name, array, lengths, size);
+}
+
+void kJSON_InsertArrayBase64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_BINARY);
+   size_t bytes = InsertArrayBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, lengths, size, eBase64);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, lengths, size, eBase64);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayBinary(jsonHandle, NULL, 0, key, array, lengths, size, eBase64));
+}
+
+void kJSON_InsertHex(kjson_t *const jsonHandle, const char *const key, const void *const data, const size_t length)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertHexWithKey(jsonHandle, &name, data, length);
+}
+
+void kJSON_InsertHexWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const data, const size_t length)
+{
+   if (NULL == data)
+   {
+      kJSON_InsertNullWithKey(jsonHandle, key);
+   }
+   else
+   {
+      STATS_INSERT(jsonHandle, KJSON_STAT_BINARY);
+      size_t bytes = InsertBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, (const uint8_t *)data, length, eHex);
+      if ((NO_FIT == bytes) && Flush(jsonHandle))
+      {
+         bytes = InsertBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, (const uint8_t *)data, length, eHex);
+      }
+      CommitEntry(jsonHandle, bytes);
+      STATS_COMMIT(jsonHandle, bytes, InsertBinary(jsonHandle, NULL, 0, key, data, length, eHex));
+   }
+}
+
+void kJSON_InsertArrayHex(kjson_t *const jsonHandle, const char *const key, const void *const *const array, const size_t *const lengths, const size_t size)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertArrayHexWithKey(jsonHandle, &name, array, lengths, size);
+}
+
+void kJSON_InsertArrayHexWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_BINARY);
+   size_t bytes = InsertArrayBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, lengths, size, eHex);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertArrayBinary(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, array, lengths, size, eHex);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertArrayBinary(jsonHandle, NULL, 0, key, array, lengths, size, eHex));
+}
+
+void kJSON_InsertRaw(kjson_t *const jsonHandle, const char *const key, const char *const json, const size_t length)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertRawWithKey(jsonHandle, &name, json, length);
+}
+
+void kJSON_InsertRawWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const json, const size_t length)
+{
+   if (NULL == json)
+   {
+      kJSON_InsertNullWithKey(jsonHandle, key);
+   }
+#if !CONFIG_KJSON_NO_RAW_CHECK
+   else if (!CheckRaw(json, length, KJSON_ASCII_OFF != jsonHandle->ascii))
+   {
+      STATS_INSERT(jsonHandle, KJSON_STAT_RAW);
+      CommitEntry(jsonHandle, REJECTED_LENGTH);
+   }
+#endif
+   else
+   {
+      STATS_INSERT(jsonHandle, KJSON_STAT_RAW);
+      size_t bytes = InsertRaw(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, json, length);
+      if ((NO_FIT == bytes) && Flush(jsonHandle))
+      {
+         bytes = InsertRaw(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, json, length);
+      }
+      CommitEntry(jsonHandle, bytes);
+      STATS_COMMIT(jsonHandle, bytes, InsertRaw(jsonHandle, NULL, 0, key, json, length));
+   }
+}
+
+void kJSON_InitRoot(kjson_t *const jsonHandle)
+{
+   SetFormat(jsonHandle);
+   STATS_START(jsonHandle);
+   if (!jsonHandle->root)
+   {
+      // Measure mode, the output is only counted and a record starts at the size so far
+      if (jsonHandle->batch)
+      {
+         jsonHandle->batchTruncated = jsonHandle->truncated;
+         jsonHandle->truncated = false;
+         jsonHandle->record = jsonHandle->size;
+      }
+      jsonHandle->size += char_size("{") + GetLineLength(jsonHandle) + char_size("}") + char_size(",");
+      jsonHandle->size += jsonHandle->batch ? char_size("\n") : 0;
+      jsonHandle->last = '{';
+      STATS_PEAK(jsonHandle, jsonHandle->size);
+      return;
+   }
+   if (jsonHandle->batch)
+   {
+      // The record is checked on its own, the batch state is restored when it ends
+      jsonHandle->batchTruncated = jsonHandle->truncated;
+      jsonHandle->truncated = false;
+      jsonHandle->record = (size_t)(jsonHandle->tail - jsonHandle->root);
+      const size_t reserve = char_size("{") + GetLineLength(jsonHandle) + char_size("}") + char_size(",") + char_size("\n");
+      if (!Reserve(jsonHandle, reserve))
+      {
+         jsonHandle->truncated = true;
+         jsonHandle->skipped++;
+         return;
+      }
+   }
+   const size_t bytes = InitRoot(jsonHandle->tail);
+   jsonHandle->size += bytes;
+   jsonHandle->tail += bytes;
+   // Account for closing brace and a spare byte, and the record separator in batch mode
+   jsonHandle->size += GetLineLength(jsonHandle) + char_size("}") + char_size(",");
+   jsonHandle->size += jsonHandle->batch ? char_size("\n") : 0;
+   jsonHandle->truncated |= (jsonHandle->size > jsonHandle->rootSize);
+   STATS_PEAK(jsonHandle, jsonHandle->size);
+}
+
+void kJSON_ExitRoot(kjson_t *const jsonHandle)
+{
+   if (jsonHandle->skipped)
+   {
+      // The record did not fit, nothing of it was written
+      jsonHandle->skipped--;
+      jsonHandle->truncated = true;
+      return;
+   }
+   if (jsonHandle->root)
+   {
+      const size_t trim = Trim(jsonHandle->tail);
+      jsonHandle->tail += trim;
+      StartLine(jsonHandle);
+      const size_t bytes = ExitRoot(jsonHandle->tail);
+      jsonHandle->tail += bytes;
+      jsonHandle->size -= GetLineLength(jsonHandle);
+   }
+   // Either the trimmed comma or the unused spare byte (now the terminator)
+   jsonHandle->size -= char_size(",");
+   STATS_OUTPUT(jsonHandle);
+   if (jsonHandle->batch)
+   {
+      EndRecord(jsonHandle);
+   }
+   else if (jsonHandle->write && jsonHandle->root)
+   {
+      jsonHandle->truncated |= !jsonHandle->write(jsonHandle->context, jsonHandle->root, jsonHandle->size);
+      jsonHandle->flushed += jsonHandle->size;
+   }
+}
+
+bool kJSON_Reset(kjson_t *const jsonHandle)
+{
+   bool written = true;
+   if (jsonHandle->batch && jsonHandle->write && jsonHandle->root && jsonHandle->size)
+   {
+      written = jsonHandle->write(jsonHandle->context, jsonHandle->root, jsonHandle->size);
+   }
+   jsonHandle->tail = jsonHandle->root;
+   jsonHandle->size = 0;
+   jsonHandle->records = 0;
+   jsonHandle->truncated = false;
+   jsonHandle->rejected = false;
+   jsonHandle->depth = 0;
+   jsonHandle->skipped = 0;
+   jsonHandle->record = 0;
+   jsonHandle->batchTruncated = false;
+   jsonHandle->flushed = 0;
+   jsonHandle->last = '\0';
+   if (jsonHandle->gather)
+   {
+      jsonHandle->gather->count = 0;
+   }
+   return written;
+}
+
+void kJSON_Checkpoint(const kjson_t *const jsonHandle, kjson_checkpoint_t *const checkpoint)
+{
+   checkpoint->offset = jsonHandle->root ? (size_t)(jsonHandle->tail - jsonHandle->root) : 0;
+   checkpoint->size = jsonHandle->size;
+   checkpoint->flushed = jsonHandle->flushed;
+   checkpoint->records = jsonHandle->records;
+   checkpoint->record = jsonHandle->record;
+   checkpoint->references = jsonHandle->gather ? jsonHandle->gather->count : 0;
+   checkpoint->depth = jsonHandle->depth;
+   checkpoint->skipped = jsonHandle->skipped;
+   checkpoint->truncated = jsonHandle->truncated;
+   checkpoint->rejected = jsonHandle->rejected;
+   checkpoint->batchTruncated = jsonHandle->batchTruncated;
+   checkpoint->last = checkpoint->offset ? jsonHandle->tail[-1] : jsonHandle->last;
+}
+
+bool kJSON_Rollback(kjson_t *const jsonHandle, const kjson_checkpoint_t *const checkpoint)
+{
+   // Flushing moves the output in the buffer, so the checkpoint no longer matches it
+   if (jsonHandle->flushed != checkpoint->flushed)
+   {
+      return false;
+   }
+   if (checkpoint->offset)
+   {
+      jsonHandle->tail = jsonHandle->root + checkpoint->offset;
+      jsonHandle->tail[-1] = checkpoint->last;
+   }
+   else
+   {
+      jsonHandle->tail = jsonHandle->root;
+      jsonHandle->last = checkpoint->last;
+   }
+   jsonHandle->size = checkpoint->size;
+   jsonHandle->records = checkpoint->records;
+   jsonHandle->record = checkpoint->record;
+   jsonHandle->depth = checkpoint->depth;
+   jsonHandle->skipped = checkpoint->skipped;
+   jsonHandle->truncated = checkpoint->truncated;
+   jsonHandle->rejected = checkpoint->rejected;
+   jsonHandle->batchTruncated = checkpoint->batchTruncated;
+   if (jsonHandle->gather && (jsonHandle->gather->count > checkpoint->references))
+   {
+      jsonHandle->gather->count = checkpoint->references;
+   }
+   if (!jsonHandle->restored || (checkpoint->offset < jsonHandle->restored - 1))
+   {
+      // Template slots recorded after the checkpoint are dropped by GetSlotCount
+      jsonHandle->restored = checkpoint->offset + 1;
+   }
+   return true;
+}
+
+void kJSON_EnterObject(kjson_t *const jsonHandle, const char *const key)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_EnterObjectWithKey(jsonHandle, key ? &name : NULL);
+}
+
+void kJSON_EnterObjectWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_CONTAINER);
+   if (!ObjectFits(jsonHandle, key))
+   {
+      jsonHandle->truncated = true;
+      jsonHandle->skipped++;
+      return;
+   }
+   if (jsonHandle->root)
+   {
+      StartEntry(jsonHandle);
+      const size_t bytes = EnterObject(jsonHandle, jsonHandle->tail, key);
+      jsonHandle->size += bytes;
+      jsonHandle->tail += bytes;
+      jsonHandle->size += GetLineLength(jsonHandle) + char_size(OBJECT_END);
+      STATS_FORMAT(jsonHandle);
+   }
+   else
+   {
+      jsonHandle->last = '{';
+   }
+#if !CONFIG_KJSON_SMALLEST
+   jsonHandle->depth++;
+#endif
+}
+
+void kJSON_ExitObject(kjson_t *const jsonHandle)
+{
+   if (jsonHandle->skipped)
+   {
+      jsonHandle->skipped--;
+      return;
+   }
+#if !CONFIG_KJSON_SMALLEST
+   jsonHandle->depth--;
+#endif
+   if (!jsonHandle->root)
+   {
+      // The closing bracket was counted when the object was entered
+      jsonHandle->last = ',';
+      return;
+   }
+   size_t bytes = Trim(jsonHandle->tail);
+   jsonHandle->tail += bytes;
+   StartLine(jsonHandle);
+   bytes = ExitObject(jsonHandle->tail);
    jsonHandle->tail += bytes;
+   jsonHandle->size -= GetLineLength(jsonHandle);
+}
+
+void kJSON_EnterArray(kjson_t *const jsonHandle, const char *const key)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_EnterArrayWithKey(jsonHandle, &name);
+}
+
+void kJSON_EnterArrayWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_CONTAINER);
+   if (!ObjectFits(jsonHandle, key))
+   {
+      jsonHandle->truncated = true;
+      jsonHandle->skipped++;
+      return;
+   }
+   if (jsonHandle->root)
+   {
+      StartEntry(jsonHandle);
+      const size_t bytes = EnterArray(jsonHandle, jsonHandle->tail, key);
+      jsonHandle->size += bytes;
+      jsonHandle->tail += bytes;
+      jsonHandle->size += GetLineLength(jsonHandle) + char_size(ARRAY_END);
+      STATS_FORMAT(jsonHandle);
+   }
+   else
+   {
+      jsonHandle->last = '[';
+   }
+#if !CONFIG_KJSON_SMALLEST
+   jsonHandle->depth++;
+#endif
+}
+
+void kJSON_ExitArray(kjson_t *const jsonHandle)
+{
+   if (jsonHandle->skipped)
+   {
+      jsonHandle->skipped--;
+      return;
+   }
 #if !CONFIG_KJSON_SMALLEST
    jsonHandle->depth--;
 #endif
-   StartEntry(jsonHandle);
+   if (!jsonHandle->root)
+   {
+      // The closing bracket was counted when the array was entered
+      jsonHandle->last = ',';
+      return;
+   }
+   size_t bytes = Trim(jsonHandle->tail);
+   jsonHandle->tail += bytes;
+   StartLine(jsonHandle);
    bytes = ExitArray(jsonHandle->tail);
    jsonHandle->tail += bytes;
-   jsonHandle->size -= strlen(jsonHandle->newLine) + jsonHandle->depth;
+   jsonHandle->size -= GetLineLength(jsonHandle);
 }
 
-//------------------------------------------------------------------------------
-// Module static functions
-//------------------------------------------------------------------------------
-static size_t InsertString(char *const string, const char *const key, const char *const value)
+void kJSON_InitFragment(kjson_t *const jsonHandle)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, STRING, key, value);
-   return (size_t)(end - start);
+   SetFormat(jsonHandle);
+}
+
+void kJSON_Splice(kjson_t *const jsonHandle, const kjson_t *const fragment)
+{
+   STATS_INSERT(jsonHandle, KJSON_STAT_SPLICE);
+   // Only a whole fragment, still in its buffer, can be copied. Its entries
+   // end with a separator like any other entry, so only the indentation changes
+   jsonHandle->rejected |= fragment->rejected;
+   jsonHandle->truncated |= fragment->truncated;
+   if (!fragment->root || fragment->depth || fragment->skipped || fragment->flushed || (fragment->gather && fragment->gather->count))
+   {
+      jsonHandle->truncated = true;
+      return;
+   }
+   const size_t length = (size_t)(fragment->tail - fragment->root);
+   if (!length)
+   {
+      return;
+   }
+   const size_t indent = GetIndentLength(jsonHandle);
+   const size_t size = length + (indent ? CountLines(fragment->root, length) * indent : 0);
+   if (!Reserve(jsonHandle, size))
+   {
+      jsonHandle->truncated = true;
+   }
+   else if (jsonHandle->root)
+   {
+      jsonHandle->size -= GetSpare(jsonHandle);
+      jsonHandle->size += size;
+      jsonHandle->tail += WriteFragment(jsonHandle, jsonHandle->tail, fragment->root, length);
+   }
+}
+
+void kJSON_InsertSlot(kjson_template_t *const templateHandle, const char *const key, const kjson_slot_e type, const unsigned int decimals)
+{
+   const kjson_key_t name = KEY_NAME(key);
+   kJSON_InsertSlotWithKey(templateHandle, &name, type, decimals);
+}
+
+void kJSON_InsertSlotWithKey(kjson_template_t *const templateHandle, const kjson_key_t *const key, const kjson_slot_e type, const unsigned int decimals)
+{
+   kjson_t *const jsonHandle = &templateHandle->json;
+   templateHandle->count = GetSlotCount(templateHandle);
+   jsonHandle->restored = 0;
+   if ((templateHandle->count >= templateHandle->slotsSize) || !jsonHandle->root || ((unsigned int)type > (unsigned int)KJSON_SLOT_STRING))
+   {
+      jsonHandle->truncated = true;
+      return;
+   }
+   const size_t bytes = InsertSlot(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key);
+   CommitEntry(jsonHandle, bytes);
+   if (bytes < REJECTED_LENGTH)
+   {
+      // The value goes in front of the separator, which Trim may remove later
+      kjson_slot_t *const slot = &templateHandle->slots[templateHandle->count++];
+      slot->offset = (size_t)(jsonHandle->tail - jsonHandle->root) - char_size(",");
+      slot->type = type;
+      slot->decimals = decimals;
+   }
+}
+
+size_t kJSON_RenderTemplate(const kjson_template_t *const templateHandle, const kjson_value_t *const values, char *const buffer, const size_t bufferSize)
+{
+   // The static text is sized once, only the values are checked against the space left.
+   // Referenced strings are not in the text, so a template that used the gather list is refused.
+   // The closing brackets are only reserved until kJSON_ExitRoot, which leaves the tail past the terminator
+   const kjson_t *const jsonHandle = &templateHandle->json;
+   const bool finished = jsonHandle->root && ((size_t)(jsonHandle->tail - jsonHandle->root) > jsonHandle->size);
+   if (!finished || jsonHandle->truncated || (jsonHandle->size >= bufferSize) || (jsonHandle->gather && jsonHandle->gather->count))
+   {
+      return 0;
+   }
+   const size_t count = GetSlotCount(templateHandle);
+   size_t space = bufferSize - char_size("\0") - jsonHandle->size;
+   size_t offset = 0;
+   char *end = buffer;
+   for (size_t i = 0; i < count; i++)
+   {
+      const kjson_slot_t *const slot = &templateHandle->slots[i];
+      memcpy(end, jsonHandle->root + offset, slot->offset - offset);
+      end += slot->offset - offset;
+      offset = slot->offset;
+      const size_t bytes = WriteSlot(jsonHandle, end, space, slot, &values[i]);
+      if (bytes >= REJECTED_LENGTH)
+      {
+         return 0;
+      }
+      end += bytes;
+      space -= bytes;
+   }
+   memcpy(end, jsonHandle->root + offset, jsonHandle->size - offset);
+   end += jsonHandle->size - offset;
+   *end = '\0';
+   return (size_t)(end - buffer);
+}
+
+size_t kJSON_Gather(const kjson_t *const jsonHandle, kjson_iovec_t *const iov, const size_t iovSize, size_t *const size)
+{
+   // The buffer is split at every reference, giving at most two entries per reference and one for the rest
+   const kjson_gather_t *const gather = jsonHandle->gather;
+   const size_t references = gather ? gather->count : 0;
+   if (!jsonHandle->root || (iovSize < 2 * references + 1))
+   {
+      return 0;
+   }
+   size_t count = 0;
+   size_t offset = 0;
+   size_t total = jsonHandle->size;
+   for (size_t i = 0; i < references; i++)
+   {
+      const kjson_reference_t *const reference = &gather->references[i];
+      iov[count].base = jsonHandle->root + offset;
+      iov[count++].length = reference->offset - offset;
+      iov[count].base = reference->value;
+      iov[count++].length = reference->length;
+      offset = reference->offset;
+      total += reference->length;
+   }
+   iov[count].base = jsonHandle->root + offset;
+   iov[count++].length = jsonHandle->size - offset;
+   if (size)
+   {
+      *size = total;
+   }
+   return count;
+}
+
+size_t kJSON_Prettify(char *const buffer, const size_t bufferSize, const char *const json, const size_t length, const char *const newLine)
+{
+   // Runs between structural characters are copied whole. A line is started
+   // before the first character of each entry, so empty objects get one too
+   Output_t output = {.buffer = buffer, .bufferSize = bufferSize, .size = 0};
+   Scanner_t scanner = {.json = json, .length = length};
+   const char *const line = newLine ? newLine : "\n";
+   const size_t lineLength = strlen(line);
+   size_t depth = 0;
+   bool inlineArray = false;
+   bool startLine = false;
+   size_t i = 0;
+   ScanWindow(&scanner, 0);
+   while (i < length)
+   {
+      const size_t next = FindNext(&scanner, i, false);
+      const char c = (next < length) ? json[next] : '\0';
+      if (startLine && ((next > i) || ('"' == c) || ('{' == c) || ('[' == c)))
+      {
+         EmitLine(&output, line, lineLength, depth - 1);
+         startLine = false;
+      }
+      Emit(&output, json + i, next - i);
+      if (next >= length)
+      {
+         break;
+      }
+      i = next + 1;
+      switch (c)
+      {
+         case '"':
+         {
+            const size_t end = SkipString(&scanner, i);
+            Emit(&output, json + next, end - next);
+            i = end;
+            break;
+         }
+         case '{':
+         case '[':
+            Emit(&output, &c, 1);
+            if (('[' == c) && IsInlineArray(&scanner, i))
+            {
+               inlineArray = true;
+            }
+            else
+            {
+               depth++;
+               startLine = true;
+            }
+            break;
+         case '}':
+         case ']':
+            if (!inlineArray && depth)
+            {
+               // Closing brackets are on their own line, at the depth of their key
+               EmitLine(&output, line, lineLength, (depth > 1) ? depth - 2 : 0);
+               startLine = false;
+               depth--;
+            }
+            inlineArray = false;
+            Emit(&output, &c, 1);
+            break;
+         case ',':
+            Emit(&output, inlineArray ? ", " : ",", inlineArray ? char_size(", ") : char_size(","));
+            startLine = !inlineArray && depth;
+            break;
+         case ':':
+            Emit(&output, ":\t", char_size(":\t"));
+            break;
+         default:
+            // Whitespace is only kept between documents, eg. NDJSON records
+            if (!depth && !inlineArray)
+            {
+               Emit(&output, &c, 1);
+            }
+            break;
+      }
+   }
+   return EndOutput(&output);
+}
+
+size_t kJSON_Minify(char *const buffer, const size_t bufferSize, const char *const json, const size_t length)
+{
+   // The output is never longer than the input, so it can be written in place
+   Output_t output = {.buffer = buffer, .bufferSize = bufferSize, .size = 0};
+   Scanner_t scanner = {.json = json, .length = length};
+   size_t depth = 0;
+   size_t i = 0;
+   ScanWindow(&scanner, 0);
+   while (i < length)
+   {
+      size_t next = FindNext(&scanner, i, false);
+      const char c = (next < length) ? json[next] : '\0';
+      if ('"' == c)
+      {
+         next = SkipString(&scanner, next + 1);
+      }
+      else if (('{' == c) || ('[' == c))
+      {
+         depth++;
+         next++;
+      }
+      else if ((('}' == c) || (']' == c)) && depth)
+      {
+         depth--;
+         next++;
+      }
+      else if ((next < length) && (((unsigned char)c > ' ') || !depth))
+      {
+         next++;
+      }
+      Emit(&output, json + i, next - i);
+      // Whitespace is only kept between documents, eg. NDJSON records
+      i = next;
+      while ((i < length) && depth && ((unsigned char)json[i] <= ' '))
+      {
+         i++;
+      }
+   }
+   return EndOutput(&output);
+}
+
+//------------------------------------------------------------------------------
+// Module static functions
+//------------------------------------------------------------------------------
+static size_t InsertString(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const char *const value)
+{
+   if (!string)
+   {
+      return MeasureString(jsonHandle, key, value);
+   }
+   char *const start = string;
+   char *end = start;
+   size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   bytes = InsertValue(jsonHandle, end, space - (size_t)(end - start), value);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if ((size_t)(end - start) >= space)
+   {
+      return NO_FIT;
+   }
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+static void CommitString(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const value)
+{
+   // Written in place, and once more after a flush when it did not fit
+   size_t bytes = InsertString(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, value);
+   if ((NO_FIT == bytes) && Flush(jsonHandle))
+   {
+      bytes = InsertString(jsonHandle, jsonHandle->tail, GetSpace(jsonHandle), key, value);
+   }
+   CommitEntry(jsonHandle, bytes);
+   STATS_COMMIT(jsonHandle, bytes, InsertString(jsonHandle, NULL, 0, key, value));
+}
+
+static KJSON_INLINE size_t InsertNumber(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key, const void *const value, const NumberType_e type, const size_t length)
+{
+   char *const start = string;
+   char *end = start;
+   end += InsertKey(jsonHandle, end, key);
+   end += WriteNumber(end, value, type, length);
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+static size_t InsertFloat(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key, const DecimalFloat_t *const value)
+{
+   char *const start = string;
+   char *end = start;
+   end += InsertKey(jsonHandle, end, key);
+   end += WriteFloat(end, value);
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+#endif // CONFIG_KJSON_NO_FLOAT
+
+static KJSON_INLINE size_t InsertBoolean(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key, bool value)
+{
+   char *const start = string;
+   char *end = start;
+   end += InsertKey(jsonHandle, end, key);
+   if (value)
+   {
+      memcpy(end, BOOLEAN_TRUE, char_size(BOOLEAN_TRUE));
+      end += char_size(BOOLEAN_TRUE);
+   }
+   else
+   {
+      memcpy(end, BOOLEAN_FALSE, char_size(BOOLEAN_FALSE));
+      end += char_size(BOOLEAN_FALSE);
+   }
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+static KJSON_INLINE size_t InsertNull(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key)
+{
+   char *const start = string;
+   char *end = start;
+   end += InsertKey(jsonHandle, end, key);
+   memcpy(end, NULL_VALUE, char_size(NULL_VALUE));
+   end += char_size(NULL_VALUE);
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+static size_t InsertArrayNumber(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const void *const array, const size_t size, const NumberType_e type, const void *const nullValue)
+{
+   // Each length is computed once, checked against the space left and used
+   // for the write. NO_FIT is returned as soon as an element does not fit
+   if (!string)
+   {
+      return MeasureArrayNumber(jsonHandle, key, array, size, type, nullValue);
+   }
+   char *const start = string;
+   char *const limit = start + ((space < NO_FIT) ? space : 0);
+   char *end = start;
+   const size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (end == limit)
+   {
+      return NO_FIT;
+   }
+   *(end++) = '[';
+   const size_t separator = GetArraySeparatorLength(jsonHandle);
+   // Elements are sized a block at a time and the block is checked against
+   // the space left once, then written without further checks
+   uint8_t lengths[NUMBER_BLOCK];
+   for (size_t i = 0; i < size; i += NUMBER_BLOCK)
+   {
+      const size_t count = ((size - i) < NUMBER_BLOCK) ? (size - i) : NUMBER_BLOCK;
+      const char *const block = (const char *)array + i * numberSizes[type];
+      if (GetNumLengths(block, count, type, nullValue, lengths) + count * separator > (size_t)(limit - end))
+      {
+         return NO_FIT;
+      }
+      for (size_t j = 0; j < count; j++)
+      {
+         if (lengths[j])
+         {
+            end += WriteNumber(end, block + j * numberSizes[type], type, lengths[j]);
+         }
+         else
+         {
+            memcpy(end, NULL_VALUE, char_size(NULL_VALUE));
+            end += char_size(NULL_VALUE);
+         }
+         end += InsertArraySeparator(end, separator);
+      }
+   }
+   return InsertArrayEnd(start, end, limit, size, separator);
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+static size_t InsertArrayFloat(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const void *const array, const size_t size, const FloatType_e type, const unsigned int decimals, const void *const nullValue)
+{
+   if (!string)
+   {
+      return MeasureArrayFloat(jsonHandle, key, array, size, type, decimals, nullValue);
+   }
+   char *const start = string;
+   char *const limit = start + ((space < NO_FIT) ? space : 0);
+   char *end = start;
+   const size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (end == limit)
+   {
+      return NO_FIT;
+   }
+   *(end++) = '[';
+   const size_t separator = GetArraySeparatorLength(jsonHandle);
+   for (size_t i = 0; i < size; i++)
+   {
+      DecimalFloat_t decimal;
+      const void *const value = (const char *)array + i * ((eFloat == type) ? sizeof(float) : sizeof(double));
+      const bool isNull = !SplitValue(value, type, decimals, nullValue, &decimal);
+      const size_t length = isNull ? char_size(NULL_VALUE) : GetFloatLength(&decimal);
+      if (length + separator > (size_t)(limit - end))
+      {
+         return NO_FIT;
+      }
+      if (isNull)
+      {
+         memcpy(end, NULL_VALUE, char_size(NULL_VALUE));
+         end += char_size(NULL_VALUE);
+      }
+      else
+      {
+         end += WriteFloat(end, &decimal);
+      }
+      end += InsertArraySeparator(end, separator);
+   }
+   return InsertArrayEnd(start, end, limit, size, separator);
+}
+#endif // CONFIG_KJSON_NO_FLOAT
+
+static size_t InsertArrayString(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const char *const *const array, const size_t size)
+{
+   if (!string)
+   {
+      return MeasureArrayString(jsonHandle, key, array, size);
+   }
+   char *const start = string;
+   char *const limit = start + ((space < NO_FIT) ? space : 0);
+   char *end = start;
+   size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (end == limit)
+   {
+      return NO_FIT;
+   }
+   *(end++) = '[';
+   const size_t separator = GetArraySeparatorLength(jsonHandle);
+   for (size_t i = 0; i < size; i++)
+   {
+      if (array[i])
+      {
+         bytes = InsertValue(jsonHandle, end, (size_t)(limit - end), array[i]);
+         if (bytes >= REJECTED_LENGTH)
+         {
+            return bytes;
+         }
+         end += bytes;
+      }
+      else
+      {
+         if (char_size(NULL_VALUE) > (size_t)(limit - end))
+         {
+            return NO_FIT;
+         }
+         memcpy(end, NULL_VALUE, char_size(NULL_VALUE));
+         end += char_size(NULL_VALUE);
+      }
+      if (separator > (size_t)(limit - end))
+      {
+         return NO_FIT;
+      }
+      end += InsertArraySeparator(end, separator);
+   }
+   return InsertArrayEnd(start, end, limit, size, separator);
+}
+
+static size_t InsertArraySeparator(char *const string, const size_t separator)
+{
+   // ", " or ",", the comma is written last so that it overwrites the space of the compact one
+   string[separator - 1] = ' ';
+   string[0] = ',';
+   return separator;
+}
+
+static size_t InsertArrayEnd(char *const start, char *end, const char *const limit, const size_t size, const size_t separator)
+{
+   // The last separator is replaced by the closing bracket
+   if (size)
+   {
+      end -= separator;
+   }
+   if (char_size(ARRAY_END) > (size_t)(limit - end))
+   {
+      return NO_FIT;
+   }
+   memcpy(end, ARRAY_END, char_size(ARRAY_END));
+   end += char_size(ARRAY_END);
+   return (size_t)(end - start);
+}
+
+static size_t InsertBinary(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const uint8_t *const data, const size_t length, const BinaryType_e type)
+{
+   // The encoded length is known from the length of the data, so the space
+   // is checked once and the data is encoded straight into the buffer
+   if (!string)
+   {
+      return MeasureBinary(jsonHandle, key, length, type);
+   }
+   char *const start = string;
+   char *end = start;
+   const size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (char_size("\"\",") + GetBinaryLength(length, type) > space - bytes)
+   {
+      return NO_FIT;
+   }
+   *(end++) = '"';
+   end += WriteBinary(end, data, length, type);
+   *(end++) = '"';
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+static size_t InsertArrayBinary(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size, const BinaryType_e type)
+{
+   if (!string)
+   {
+      return MeasureArrayBinary(jsonHandle, key, array, lengths, size, type);
+   }
+   char *const start = string;
+   char *const limit = start + ((space < NO_FIT) ? space : 0);
+   char *end = start;
+   const size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (end == limit)
+   {
+      return NO_FIT;
+   }
+   *(end++) = '[';
+   const size_t separator = GetArraySeparatorLength(jsonHandle);
+   for (size_t i = 0; i < size; i++)
+   {
+      const size_t length = array[i] ? char_size("\"\"") + GetBinaryLength(lengths[i], type) : char_size(NULL_VALUE);
+      if (length + separator > (size_t)(limit - end))
+      {
+         return NO_FIT;
+      }
+      if (array[i])
+      {
+         *(end++) = '"';
+         end += WriteBinary(end, (const uint8_t *)array[i], lengths[i], type);
+         *(end++) = '"';
+      }
+      else
+      {
+         memcpy(end, NULL_VALUE, char_size(NULL_VALUE));
+         end += char_size(NULL_VALUE);
+      }
+      end += InsertArraySeparator(end, separator);
+   }
+   return InsertArrayEnd(start, end, limit, size, separator);
+}
+
+static size_t InsertRaw(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key, const char *const json, const size_t length)
+{
+   // The value is already serialised, it is copied as it is after the key
+   if (!string)
+   {
+      return MeasureRaw(jsonHandle, key, length);
+   }
+   char *const start = string;
+   char *end = start;
+   const size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (length >= space - bytes)
+   {
+      return NO_FIT;
+   }
+   memcpy(end, json, length);
+   end += length;
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+static size_t InsertSlot(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key)
+{
+   // Key of a template value, the value itself is written by WriteSlot
+   char *const start = string;
+   char *end = start;
+   const size_t bytes = InsertPrefix(jsonHandle, end, space, key);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if ((size_t)(end - start) >= space)
+   {
+      return NO_FIT;
+   }
+   *(end++) = ',';
+   return (size_t)(end - start);
+}
+
+static size_t WriteSlot(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_slot_t *const slot, const kjson_value_t *const value)
+{
+   NumberType_e numberType;
+   const void *nullValue;
+   switch (slot->type)
+   {
+      case KJSON_SLOT_NUMBER:
+         numberType = eSigned;
+         nullValue = &jsonHandle->nullIntValue;
+         break;
+      case KJSON_SLOT_UNSIGNED_NUMBER:
+         numberType = eUnsigned;
+         nullValue = &jsonHandle->nullUIntValue;
+         break;
+      case KJSON_SLOT_NUMBER64:
+         numberType = eSigned64;
+         nullValue = &jsonHandle->nullInt64Value;
+         break;
+      case KJSON_SLOT_UNSIGNED_NUMBER64:
+         numberType = eUnsigned64;
+         nullValue = &jsonHandle->nullUInt64Value;
+         break;
+#if !CONFIG_KJSON_NO_FLOAT
+      case KJSON_SLOT_FLOAT:
+      case KJSON_SLOT_DOUBLE:
+      {
+         DecimalFloat_t decimal;
+         const bool isFloat = (KJSON_SLOT_FLOAT == slot->type);
+         const void *const number = isFloat ? (const void *)&value->floatNumber : (const void *)&value->doubleNumber;
+         const void *const nullNumber = isFloat ? (const void *)&jsonHandle->nullFloatValue : (const void *)&jsonHandle->nullDoubleValue;
+         if (!SplitValue(number, isFloat ? eFloat : eDouble, slot->decimals, nullNumber, &decimal))
+         {
+            return WriteNull(string, space);
+         }
+         if (GetFloatLength(&decimal) > space)
+         {
+            return NO_FIT;
+         }
+         return WriteFloat(string, &decimal);
+      }
+#endif
+      case KJSON_SLOT_BOOLEAN:
+      {
+         const char *const text = value->boolean ? BOOLEAN_TRUE : BOOLEAN_FALSE;
+         const size_t length = value->boolean ? char_size(BOOLEAN_TRUE) : char_size(BOOLEAN_FALSE);
+         if (length > space)
+         {
+            return NO_FIT;
+         }
+         memcpy(string, text, length);
+         return length;
+      }
+      case KJSON_SLOT_STRING:
+         if (NULL == value->string)
+         {
+            return WriteNull(string, space);
+         }
+         return InsertQuoted(jsonHandle, string, space, value->string);
+      default:
+         return REJECTED_LENGTH;
+   }
+
+   if (IsNumberNull(value, numberType, nullValue))
+   {
+      return WriteNull(string, space);
+   }
+   const size_t length = GetNumLength(value, numberType);
+   if (length > space)
+   {
+      return NO_FIT;
+   }
+   return WriteNumber(string, value, numberType, length);
+}
+
+static size_t GetSlotCount(const kjson_template_t *const templateHandle)
+{
+   // Slots are recorded in order, the ones at or after an offset restored by kJSON_Rollback were rolled back
+   const size_t restored = templateHandle->json.restored;
+   size_t count = templateHandle->count;
+   while (restored && count && (templateHandle->slots[count - 1].offset >= restored - 1))
+   {
+      count--;
+   }
+   return count;
+}
+
+static size_t WriteNull(char *const string, const size_t space)
+{
+   if (char_size(NULL_VALUE) > space)
+   {
+      return NO_FIT;
+   }
+   memcpy(string, NULL_VALUE, char_size(NULL_VALUE));
+   return char_size(NULL_VALUE);
+}
+
+static size_t InitRoot(char *const string)
+{
+   char *const start = string;
+   char *end = start;
+   *(end++) = '{';
+   return (size_t)(end - start);
+}
+
+static size_t Trim(char *const string)
+{
+   const char *const start = string;
+   const char *const end = start - 1;
+   if (',' == *end)
+   {
+      return (size_t)-1;
+   }
+   return 0;
+}
+
+static size_t ExitRoot(char *const string)
+{
+   char *const start = string;
+   char *end = start;
+   *(end++) = '}';
+   *(end++) = '\0';
+   return (size_t)(end - start);
+}
+
+static size_t EnterObject(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key)
+{
+   char *const start = string;
+   char *end = start;
+   if (key)
+   {
+      end += InsertKey(jsonHandle, end, key);
+   }
+   *(end++) = '{';
+   return (size_t)(end - start);
+}
+
+static size_t ExitObject(char *const string)
+{
+   char *const start = string;
+   char *end = start;
+   memcpy(end, OBJECT_END, char_size(OBJECT_END));
+   end += char_size(OBJECT_END);
+   return (size_t)(end - start);
+}
+
+static size_t EnterArray(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key)
+{
+   char *const start = string;
+   char *end = start;
+   end += InsertKey(jsonHandle, end, key);
+   *(end++) = '[';
+   return (size_t)(end - start);
+}
+
+static size_t ExitArray(char *const string)
+{
+   char *const start = string;
+   char *end = start;
+   memcpy(end, ARRAY_END, char_size(ARRAY_END));
+   end += char_size(ARRAY_END);
+   return (size_t)(end - start);
+}
+
+static size_t InsertLine(const kjson_t *const jsonHandle, char *const string)
+{
+   // Newline and indentation, copied from the precomputed start of line
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+   unused(string);
+   return 0;
+#else
+   const size_t length = GetLineLength(jsonHandle);
+   if (!length)
+   {
+      // Compact output, no call for an empty copy
+      return 0;
+   }
+   if (length <= sizeof(jsonHandle->lines))
+   {
+      memcpy(string, jsonHandle->lines, length);
+   }
+   else
+   {
+      memcpy(string, jsonHandle->newLine, jsonHandle->lineLength);
+      memset(string + jsonHandle->lineLength, jsonHandle->indent, length - jsonHandle->lineLength);
+   }
+   return length;
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static size_t InsertKeySeparator(const kjson_t *const jsonHandle, char *const string)
+{
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+   unused(string);
+   return 0;
+#else
+   if (1 == jsonHandle->keySeparatorLength)
+   {
+      *string = *jsonHandle->keySeparator;
+   }
+   else if (jsonHandle->keySeparatorLength)
+   {
+      memcpy(string, jsonHandle->keySeparator, jsonHandle->keySeparatorLength);
+   }
+   return jsonHandle->keySeparatorLength;
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static KJSON_INLINE size_t InsertKey(const kjson_t *const jsonHandle, char *const string, const kjson_key_t *const key)
+{
+   // Only used once the entry is known to fit. Kept small so that it is inlined,
+   // a literal key (KJSON_KEY) is then copied with a memcpy of constant size
+   size_t bytes = key->length;
+   if (bytes)
+   {
+      memcpy(string, key->text, bytes);
+   }
+   else
+   {
+      bytes = WriteKey(jsonHandle, string, NO_FIT, key->text, 0);
+   }
+   return bytes + InsertKeySeparator(jsonHandle, string + bytes);
+}
+
+static size_t WriteKey(const kjson_t *const jsonHandle, char *const string, const size_t space, const char *const key, const size_t separator)
+{
+   // Quoted and escaped key followed by ':', bounded by space with room left
+   // for the key separator. The caller has checked that the quote fits
+   char *end = string;
+   *(end++) = '"';
+   const size_t bytes = WriteEscaped(end, space - char_size("\""), key, jsonHandle->ascii);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   if (char_size(KEY_END) + separator > space - (size_t)(end - string))
+   {
+      return NO_FIT;
+   }
+   memcpy(end, KEY_END, char_size(KEY_END));
+   end += char_size(KEY_END);
+   return (size_t)(end - string);
+}
+
+static size_t InsertPrefix(const kjson_t *const jsonHandle, char *const string, const size_t space, const kjson_key_t *const key)
+{
+   // Depth and key of a speculative entry, bounded by space
+   char *const start = string;
+   char *end = start;
+   if (GetLineLength(jsonHandle) + char_size("\"") > space)
+   {
+      return NO_FIT;
+   }
+   end += InsertLine(jsonHandle, end);
+   const size_t separator = GetKeySeparatorLength(jsonHandle);
+   const size_t left = space - (size_t)(end - start);
+   size_t bytes = key->length;
+   if (!bytes)
+   {
+      bytes = WriteKey(jsonHandle, end, left, key->text, separator);
+      if (bytes >= REJECTED_LENGTH)
+      {
+         return bytes;
+      }
+   }
+   else if (bytes + separator > left)
+   {
+      return NO_FIT;
+   }
+   else
+   {
+      memcpy(end, key->text, bytes);
+   }
+   end += bytes;
+   end += InsertKeySeparator(jsonHandle, end);
+   return (size_t)(end - start);
+}
+
+static size_t InsertQuoted(const kjson_t *const jsonHandle, char *const string, const size_t space, const char *const value)
+{
+   char *const start = string;
+   char *end = start;
+   if (char_size("\"\"") > space)
+   {
+      return NO_FIT;
+   }
+   *(end++) = '"';
+   const size_t bytes = WriteEscaped(end, space - char_size("\"\""), value, jsonHandle->ascii);
+   if (bytes >= REJECTED_LENGTH)
+   {
+      return bytes;
+   }
+   end += bytes;
+   *(end++) = '"';
+   return (size_t)(end - start);
+}
+
+static size_t InsertValue(const kjson_t *const jsonHandle, char *const string, const size_t space, const char *const value)
+{
+   // Long strings that need no escaping are referenced in the gather list
+   // instead of being copied, only their quotes are written
+   kjson_gather_t *const gather = jsonHandle->gather;
+   if (gather && !jsonHandle->write && (gather->count < gather->referencesSize))
+   {
+      const size_t length = strlen(value);
+      if ((length >= gather->threshold) && (length == FindEscape(value, length, KJSON_ASCII_OFF != jsonHandle->ascii)))
+      {
+         if (char_size("\"\"") > space)
+         {
+            return NO_FIT;
+         }
+         string[0] = '"';
+         string[1] = '"';
+         kjson_reference_t *const reference = &gather->references[gather->count++];
+         reference->value = value;
+         reference->length = length;
+         reference->offset = (size_t)(string - jsonHandle->root) + char_size("\"");
+         return char_size("\"\"");
+      }
+   }
+   return InsertQuoted(jsonHandle, string, space, value);
+}
+
+static size_t GetPrefixLength(const kjson_t *const jsonHandle, const kjson_key_t *const key)
+{
+   // Depth and key of an entry, as InsertPrefix writes them
+   size_t length = key->length;
+   if (!length)
+   {
+      length = GetEscapedLength(key->text, jsonHandle->ascii);
+      if (length >= REJECTED_LENGTH)
+      {
+         return length;
+      }
+      length += char_size("\"") + char_size(KEY_END);
+   }
+   return GetLineLength(jsonHandle) + length + GetKeySeparatorLength(jsonHandle);
+}
+
+static size_t GetArrayLength(const kjson_t *const jsonHandle, const size_t length, const size_t size)
+{
+   // Brackets and separators around values of the given total length
+   const size_t separator = GetArraySeparatorLength(jsonHandle);
+   const size_t separators = size ? (size - 1) * separator : 0;
+   return char_size("[") + length + separators + char_size(ARRAY_END);
+}
+
+static size_t GetLineLength(const kjson_t *const jsonHandle)
+{
+   // Newline and indentation at the current depth
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+   return 0;
+#else
+   return jsonHandle->lineLength + GetIndentLength(jsonHandle);
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static size_t GetIndentLength(const kjson_t *const jsonHandle)
+{
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+   return 0;
+#else
+   return (size_t)jsonHandle->depth * jsonHandle->indentWidth;
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static size_t GetKeySeparatorLength(const kjson_t *const jsonHandle)
+{
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+   return 0;
+#else
+   return jsonHandle->keySeparatorLength;
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static size_t GetArraySeparatorLength(const kjson_t *const jsonHandle)
+{
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+   return char_size(",");
+#else
+   return jsonHandle->arraySeparatorLength;
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static void SetFormat(kjson_t *const jsonHandle)
+{
+   // Resolves the format once per document, the start of every line is then
+   // a single copy of the newline followed by as much indentation as fits
+#if CONFIG_KJSON_SMALLEST
+   jsonHandle->newLine = "";
+#else
+   static const kjson_format_t pretty = KJSON_FORMAT_PRETTY;
+   const kjson_format_t *const format = jsonHandle->format ? jsonHandle->format : &pretty;
+   if (!jsonHandle->newLine)
+   {
+      jsonHandle->newLine = "";
+   }
+   if (!format->pretty)
+   {
+      jsonHandle->keySeparator = "";
+      jsonHandle->lineLength = 0;
+      jsonHandle->keySeparatorLength = 0;
+      jsonHandle->arraySeparatorLength = (unsigned char)char_size(",");
+      jsonHandle->indentWidth = 0;
+      jsonHandle->indent = '\0';
+      return;
+   }
+   jsonHandle->keySeparator = format->keySeparator ? format->keySeparator : "";
+   jsonHandle->lineLength = strlen(jsonHandle->newLine);
+   jsonHandle->keySeparatorLength = strlen(jsonHandle->keySeparator);
+   jsonHandle->arraySeparatorLength = (unsigned char)char_size(ARRAY_SEPARATOR);
+   jsonHandle->indentWidth = format->indentWidth;
+   jsonHandle->indent = format->indent;
+   if (jsonHandle->lineLength <= sizeof(jsonHandle->lines))
+   {
+      memcpy(jsonHandle->lines, jsonHandle->newLine, jsonHandle->lineLength);
+      memset(jsonHandle->lines + jsonHandle->lineLength, format->indent, sizeof(jsonHandle->lines) - jsonHandle->lineLength);
+   }
+#endif // CONFIG_KJSON_SMALLEST
+}
+
+static size_t MeasureString(const kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const value)
+{
+   // Size of the entry InsertString writes, the measuring functions are
+   // used instead of the writers when there is no buffer
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   const size_t length = GetEscapedLength(value, jsonHandle->ascii);
+   if (length >= REJECTED_LENGTH)
+   {
+      return length;
+   }
+   return prefix + char_size("\"\"") + length + char_size(",");
+}
+
+static size_t MeasureArrayNumber(const kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const array, const size_t size, const NumberType_e type, const void *const nullValue)
+{
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   size_t length = 0;
+   uint8_t lengths[NUMBER_BLOCK];
+   for (size_t i = 0; i < size; i += NUMBER_BLOCK)
+   {
+      const size_t count = ((size - i) < NUMBER_BLOCK) ? (size - i) : NUMBER_BLOCK;
+      length += GetNumLengths((const char *)array + i * numberSizes[type], count, type, nullValue, lengths);
+   }
+   return prefix + GetArrayLength(jsonHandle, length, size);
+}
+
+static size_t MeasureArrayString(const kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const *const array, const size_t size)
+{
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   size_t length = 0;
+   for (size_t i = 0; i < size; i++)
+   {
+      if (array[i])
+      {
+         const size_t bytes = GetEscapedLength(array[i], jsonHandle->ascii);
+         if (bytes >= REJECTED_LENGTH)
+         {
+            return bytes;
+         }
+         length += char_size("\"\"") + bytes;
+      }
+      else
+      {
+         length += char_size(NULL_VALUE);
+      }
+   }
+   return prefix + GetArrayLength(jsonHandle, length, size);
+}
+
+static size_t MeasureBinary(const kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t length, const BinaryType_e type)
+{
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   return prefix + char_size("\"\"") + GetBinaryLength(length, type) + char_size(",");
+}
+
+static size_t MeasureArrayBinary(const kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size, const BinaryType_e type)
+{
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   size_t length = 0;
+   for (size_t i = 0; i < size; i++)
+   {
+      length += array[i] ? char_size("\"\"") + GetBinaryLength(lengths[i], type) : char_size(NULL_VALUE);
+   }
+   return prefix + GetArrayLength(jsonHandle, length, size);
+}
+
+static size_t MeasureRaw(const kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t length)
+{
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   return prefix + length + char_size(",");
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+static size_t MeasureArrayFloat(const kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const array, const size_t size, const FloatType_e type, const unsigned int decimals, const void *const nullValue)
+{
+   const size_t prefix = GetPrefixLength(jsonHandle, key);
+   if (prefix >= REJECTED_LENGTH)
+   {
+      return prefix;
+   }
+   size_t length = 0;
+   for (size_t i = 0; i < size; i++)
+   {
+      DecimalFloat_t decimal;
+      const void *const value = (const char *)array + i * ((eFloat == type) ? sizeof(float) : sizeof(double));
+      length += SplitValue(value, type, decimals, nullValue, &decimal) ? GetFloatLength(&decimal) : char_size(NULL_VALUE);
+   }
+   return prefix + GetArrayLength(jsonHandle, length, size);
+}
+#endif // CONFIG_KJSON_NO_FLOAT
+
+static size_t CountLines(const char *const string, const size_t length)
+{
+   // Line breaks of a fragment, the strings in it are escaped so any '\n' is one
+   size_t count = 0;
+   const char *start = string;
+   const char *const limit = string + length;
+   const char *line;
+   while ((line = (const char *)memchr(start, '\n', (size_t)(limit - start))) != NULL)
+   {
+      count++;
+      start = line + 1;
+   }
+   return count;
+}
+
+static size_t WriteFragment(const kjson_t *const jsonHandle, char *const string, const char *const fragment, const size_t length)
+{
+   // Copies the fragment, indenting every line to the depth of the parent
+   char *end = string;
+   const char *start = fragment;
+   const char *const limit = fragment + length;
+#if CONFIG_KJSON_SMALLEST
+   unused(jsonHandle);
+#else
+   const size_t indent = GetIndentLength(jsonHandle);
+   const char *line;
+   while (indent && ((line = (const char *)memchr(start, '\n', (size_t)(limit - start))) != NULL))
+   {
+      memcpy(end, start, (size_t)(line + 1 - start));
+      end += line + 1 - start;
+      memset(end, jsonHandle->indent, indent);
+      end += indent;
+      start = line + 1;
+   }
+#endif // CONFIG_KJSON_SMALLEST
+   memcpy(end, start, (size_t)(limit - start));
+   end += limit - start;
+   return (size_t)(end - string);
+}
+
+static void StartEntry(kjson_t *const jsonHandle)
+{
+   jsonHandle->size -= GetSpare(jsonHandle);
+   StartLine(jsonHandle);
+}
+
+static void StartLine(kjson_t *const jsonHandle)
+{
+   const size_t bytes = InsertLine(jsonHandle, jsonHandle->tail);
+   jsonHandle->size += bytes;
+   jsonHandle->tail += bytes;
+}
+
+static size_t GetSpare(const kjson_t *const jsonHandle)
+{
+   // Objects and arrays reserve their closing bracket and a spare byte for
+   // the comma that follows it. The first entry gives the spare byte back,
+   // as its own comma is the one replaced by the closing bracket
+   char last = jsonHandle->last;
+   if (jsonHandle->tail != jsonHandle->root)
+   {
+      last = jsonHandle->tail[-1];
+   }
+   return (('{' == last) || ('[' == last)) ? char_size(",") : 0;
+}
+
+static size_t GetSpace(const kjson_t *const jsonHandle)
+{
+   // Bytes left for the next entry, closing brackets are already reserved in size.
+   // Nothing fits inside an object or array that was dropped
+   if (jsonHandle->skipped)
+   {
+      return 0;
+   }
+   const size_t size = jsonHandle->size - GetSpare(jsonHandle);
+   return (size < jsonHandle->rootSize) ? (jsonHandle->rootSize - size) : 0;
+}
+
+static void CommitEntry(kjson_t *const jsonHandle, const size_t bytes)
+{
+   // A speculative entry is kept only if it was written completely,
+   // otherwise tail and size are left where they were
+   if (!jsonHandle->root)
+   {
+      jsonHandle->truncated |= !Measure(jsonHandle, bytes);
+      jsonHandle->rejected |= (REJECTED_LENGTH == bytes);
+   }
+   else if (bytes >= REJECTED_LENGTH)
+   {
+      jsonHandle->truncated = true;
+      jsonHandle->rejected |= (REJECTED_LENGTH == bytes);
+      DropReferences(jsonHandle);
+      STATS_TRUNCATION(jsonHandle, bytes);
+   }
+   else
+   {
+      jsonHandle->size -= GetSpare(jsonHandle);
+      jsonHandle->size += bytes;
+      jsonHandle->tail += bytes;
+      STATS_PEAK(jsonHandle, jsonHandle->size);
+   }
+}
+
+static bool Flush(kjson_t *const jsonHandle)
+{
+   // Hands the output so far to the sink, except for the last byte which
+   // stays for Trim and GetSpare to look back at. Reserved closing brackets
+   // are still counted in size, they are written after the flush. In batch
+   // mode only whole records are handed over, the record being written is
+   // moved to the start of the buffer so that it can still be rolled back
+   const size_t used = (size_t)(jsonHandle->tail - jsonHandle->root);
+   if (!jsonHandle->write || jsonHandle->skipped || (used <= char_size(",")))
+   {
+      return false;
+   }
+   const size_t bytes = jsonHandle->batch ? jsonHandle->record : (used - char_size(","));
+   if (!bytes || !jsonHandle->write(jsonHandle->context, jsonHandle->root, bytes))
+   {
+      return false;
+   }
+   memmove(jsonHandle->root, jsonHandle->root + bytes, used - bytes);
+   jsonHandle->tail -= bytes;
+   jsonHandle->size -= bytes;
+   jsonHandle->record -= jsonHandle->batch ? bytes : 0;
+   jsonHandle->flushed += bytes;
+   return true;
+}
+
+static bool Reserve(kjson_t *const jsonHandle, const size_t size)
+{
+   // Flushes to the sink, if there is one, when the entry does not fit.
+   // In measure mode everything fits and the entry is counted here instead
+   if (!jsonHandle->root)
+   {
+      return Measure(jsonHandle, size);
+   }
+   const bool fits = (size <= GetSpace(jsonHandle)) || (Flush(jsonHandle) && (size <= GetSpace(jsonHandle)));
+   STATS_RESERVE(jsonHandle, size, fits);
+   return fits;
+}
+
+static bool Measure(kjson_t *const jsonHandle, const size_t size)
+{
+   // Counts an entry as if it had been written. Rejected entries, and the
+   // entries of an object or array that was dropped, are still left out
+   if ((size >= REJECTED_LENGTH) || jsonHandle->skipped)
+   {
+      STATS_TRUNCATION(jsonHandle, size);
+      return false;
+   }
+   jsonHandle->size -= GetSpare(jsonHandle);
+   jsonHandle->size += size;
+   jsonHandle->last = ',';
+   STATS_PEAK(jsonHandle, jsonHandle->size);
+   return true;
+}
+
+static void DropReferences(kjson_t *const jsonHandle)
+{
+   // References past the tail belong to output that was rolled back
+   kjson_gather_t *const gather = jsonHandle->gather;
+   const size_t offset = (size_t)(jsonHandle->tail - jsonHandle->root);
+   while (gather && gather->count && (gather->references[gather->count - 1].offset >= offset))
+   {
+      gather->count--;
+   }
+}
+
+static void EndRecord(kjson_t *const jsonHandle)
+{
+   // A record is kept only if it was written whole, otherwise the buffer is
+   // rolled back to its start. The terminator is replaced by the separator
+   // reserved in kJSON_InitRoot, and the new one is overwritten by the next record
+   if (jsonHandle->truncated)
+   {
+      jsonHandle->size = jsonHandle->record;
+      if (jsonHandle->root)
+      {
+         jsonHandle->tail = jsonHandle->root + jsonHandle->record;
+         jsonHandle->tail[0] = '\0';
+         DropReferences(jsonHandle);
+      }
+   }
+   else
+   {
+      if (jsonHandle->root)
+      {
+         jsonHandle->tail[-1] = '\n';
+         jsonHandle->tail[0] = '\0';
+      }
+      jsonHandle->records++;
+      jsonHandle->truncated = jsonHandle->batchTruncated;
+   }
+}
+
+#if CONFIG_KJSON_STATS
+static void CountInsert(kjson_t *const jsonHandle, const kjson_stat_e type)
+{
+   jsonHandle->stats.inserts[type]++;
+#if CONFIG_KJSON_STATS_CYCLES
+   jsonHandle->stats.mark = KJSON_CYCLES();
+#endif
+}
+
+static void CountTruncation(kjson_t *const jsonHandle, const size_t size)
+{
+   // The size tells rejected entries from those that did not fit. The size
+   // of a speculative entry is not known yet, CountCommit adds its shortfall
+   kjson_stats_t *const stats = &jsonHandle->stats;
+   if (jsonHandle->skipped)
+   {
+      stats->dropped++;
+   }
+   else if ((size >= REJECTED_LENGTH) && (NO_FIT != size))
+   {
+      stats->rejections++;
+   }
+   else
+   {
+      stats->truncations++;
+      CountShortfall(jsonHandle, size);
+   }
+}
+
+static void CountShortfall(kjson_t *const jsonHandle, const size_t size)
+{
+   if (jsonHandle->skipped || (size >= REJECTED_LENGTH))
+   {
+      return;
+   }
+   kjson_stats_t *const stats = &jsonHandle->stats;
+   const size_t space = GetSpace(jsonHandle);
+   const size_t shortfall = (size > space) ? (size - space) : 0;
+   stats->shortfall += shortfall;
+   stats->maxShortfall = (shortfall > stats->maxShortfall) ? shortfall : stats->maxShortfall;
+}
+
+static void CountCommit(kjson_t *const jsonHandle, const size_t needed)
+{
+   // Speculative writers check space as they write, all of it is formatting
+   if (needed)
+   {
+      CountShortfall(jsonHandle, needed);
+   }
+   STATS_FORMAT(jsonHandle);
+}
+
+static void CountPeak(kjson_t *const jsonHandle, const size_t size)
+{
+   if (size > jsonHandle->stats.peakSize)
+   {
+      jsonHandle->stats.peakSize = size;
+   }
+}
+
+static void CountOutput(kjson_t *const jsonHandle)
+{
+   // A truncated record is rolled back by EndRecord, none of it is output
+   if (!jsonHandle->batch || !jsonHandle->truncated)
+   {
+      jsonHandle->stats.bytes += jsonHandle->flushed + jsonHandle->size - jsonHandle->stats.start;
+   }
+}
+#endif
+
+#if CONFIG_KJSON_STATS_CYCLES
+static void CountCycles(kjson_t *const jsonHandle, uint64_t *const cycles)
+{
+   const uint64_t now = KJSON_CYCLES();
+   *cycles += now - jsonHandle->stats.mark;
+   jsonHandle->stats.mark = now;
+}
+#endif
+
+static size_t WriteUnsigned(char *const string, uint32_t value, const size_t length)
+{
+   // Digits are produced two at a time, from the least significant end.
+   // A length above the number of digits pads the output with zeros
+   char *end = string + length;
+   while (end > string + 1)
+   {
+      const size_t pair = (size_t)(value % 100) * 2;
+      value /= 100;
+      *(--end) = digitPairs[pair + 1];
+      *(--end) = digitPairs[pair];
+   }
+   if (end > string)
+   {
+      *(--end) = (char)('0' + value);
+   }
+   return length;
+}
+
+static size_t WriteSigned(char *const string, const int value, const size_t length)
+{
+   if (value < 0)
+   {
+      string[0] = '-';
+      WriteUnsigned(string + 1, 0u - (uint32_t)value, length - 1);
+   }
+   else
+   {
+      WriteUnsigned(string, (uint32_t)value, length);
+   }
+   return length;
+}
+
+static size_t WriteUnsigned64(char *const string, uint64_t value, const size_t length)
+{
+   char *end = string + length;
+   while (value > UINT32_MAX)
+   {
+      const size_t pair = (size_t)(value % 100) * 2;
+      value /= 100;
+      *(--end) = digitPairs[pair + 1];
+      *(--end) = digitPairs[pair];
+   }
+   WriteUnsigned(string, (uint32_t)value, (size_t)(end - string));
+   return length;
+}
+
+static size_t WriteSigned64(char *const string, const int64_t value, const size_t length)
+{
+   if (value < 0)
+   {
+      string[0] = '-';
+      WriteUnsigned64(string + 1, 0u - (uint64_t)value, length - 1);
+   }
+   else
+   {
+      WriteUnsigned64(string, (uint64_t)value, length);
+   }
+   return length;
+}
+
+static size_t WriteNumber(char *const string, const void *const value, const NumberType_e type, const size_t length)
+{
+   switch (type)
+   {
+      case eSigned:
+      case eSigned8:
+      case eSigned16:
+      case eSigned32:
+         return WriteSigned(string, (int)LoadSigned(value, type), length);
+      case eUnsigned64:
+         return WriteUnsigned64(string, *(const uint64_t *)value, length);
+      case eSigned64:
+         return WriteSigned64(string, *(const int64_t *)value, length);
+      default:
+         return WriteUnsigned(string, LoadUnsigned(value, type), length);
+   }
+}
+
+static size_t GetNumDigits(const uint32_t value)
+{
+   // log10 is estimated from the bit length (1233 / 4096 ~= log10(2)),
+   // then corrected with a single comparison against the power of 10
+#if defined(__GNUC__)
+   const uint32_t bits = (uint32_t)(32 - __builtin_clz(value | 1));
+#else
+   uint32_t bits = 1;
+   while ((bits < 32) && (value >> bits))
+   {
+      bits++;
+   }
+#endif
+   const uint32_t estimate = (bits * 1233) >> 12;
+   return (size_t)estimate + 1 - ((value | 1) < powersOf10[estimate]);
+}
+
+static size_t GetNumDigits64(const uint64_t value)
+{
+   if (value <= UINT32_MAX)
+   {
+      return GetNumDigits((uint32_t)value);
+   }
+#if defined(__GNUC__)
+   const uint32_t bits = (uint32_t)(64 - __builtin_clzll(value));
+#else
+   uint32_t bits = 33;
+   while ((bits < 64) && (value >> bits))
+   {
+      bits++;
+   }
+#endif
+   const uint32_t estimate = (bits * 1233) >> 12;
+   return (size_t)estimate + 1 - (value < powersOf10[estimate]);
+}
+
+static size_t GetNumLength(const void *const value, const NumberType_e type)
+{
+   switch (type)
+   {
+      case eSigned:
+      case eSigned8:
+      case eSigned16:
+      case eSigned32:
+      {
+         const int32_t num = LoadSigned(value, type);
+         if (num < 0)
+         {
+            return GetNumDigits(0u - (uint32_t)num) + char_size("-");
+         }
+         return GetNumDigits((uint32_t)num);
+      }
+      case eUnsigned64:
+         return GetNumDigits64(*(const uint64_t *)value);
+      case eSigned64:
+      {
+         const int64_t num = *(const int64_t *)value;
+         if (num < 0)
+         {
+            return GetNumDigits64(0u - (uint64_t)num) + char_size("-");
+         }
+         return GetNumDigits64((uint64_t)num);
+      }
+      default:
+         return GetNumDigits(LoadUnsigned(value, type));
+   }
+}
+
+static bool IsNumberNull(const void *const value, const NumberType_e type, const void *const nullValue)
+{
+   switch (type)
+   {
+      case eSigned:
+      case eSigned8:
+      case eSigned16:
+      case eSigned32:
+         return LoadSigned(value, type) == LoadSigned(nullValue, type);
+      case eUnsigned64:
+         return *(const uint64_t *)value == *(const uint64_t *)nullValue;
+      case eSigned64:
+         return *(const int64_t *)value == *(const int64_t *)nullValue;
+      default:
+         return LoadUnsigned(value, type) == LoadUnsigned(nullValue, type);
+   }
+}
+
+static size_t GetNumLengths(const void *const array, const size_t size, const NumberType_e type, const void *const nullValue, uint8_t *const lengths)
+{
+   // Stores the length of each number, 0 for a null, and returns the total
+   // length with the nulls. Elements of up to 32 bits are sized 8 or 4 at a
+   // time in 32-bit lanes, the rest one at a time
+   const char *const values = (const char *)array;
+   const size_t elementSize = numberSizes[type];
+   size_t i = 0;
+   size_t total = 0;
+#if KJSON_SSE2
+   if (elementSize <= sizeof(uint32_t))
+   {
+      const bool isSigned = (eSigned == type) || (eSigned8 == type) || (eSigned16 == type) || (eSigned32 == type);
+      const int32_t null = isSigned ? LoadSigned(nullValue, type) : (int32_t)LoadUnsigned(nullValue, type);
+      __m128i sum = _mm_setzero_si128();
+      __m128i nulls = _mm_setzero_si128();
+#if KJSON_AVX2
+      __m256i sum8 = _mm256_setzero_si256();
+      __m256i nulls8 = _mm256_setzero_si256();
+      for (; i + 8 <= size; i += 8)
+      {
+         const __m256i lanes = LoadLanes8(values + i * elementSize, type);
+         const __m256i isNull = _mm256_cmpeq_epi32(lanes, _mm256_set1_epi32(null));
+         const __m256i length = _mm256_andnot_si256(isNull, CountDigits8(lanes, isSigned));
+         sum8 = _mm256_add_epi32(sum8, length);
+         nulls8 = _mm256_sub_epi32(nulls8, isNull);
+         const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(length), _mm256_extracti128_si256(length, 1));
+         _mm_storel_epi64((__m128i *)(void *)(lengths + i), _mm_packus_epi16(packed, packed));
+      }
+      sum = _mm_add_epi32(_mm256_castsi256_si128(sum8), _mm256_extracti128_si256(sum8, 1));
+      nulls = _mm_add_epi32(_mm256_castsi256_si128(nulls8), _mm256_extracti128_si256(nulls8, 1));
+#endif
+      for (; i + 4 <= size; i += 4)
+      {
+         const __m128i lanes = LoadLanes4(values + i * elementSize, type);
+         const __m128i isNull = _mm_cmpeq_epi32(lanes, _mm_set1_epi32(null));
+         const __m128i length = _mm_andnot_si128(isNull, CountDigits4(lanes, isSigned));
+         sum = _mm_add_epi32(sum, length);
+         nulls = _mm_sub_epi32(nulls, isNull);
+         const __m128i packed = _mm_packs_epi32(length, length);
+         const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+         memcpy(lengths + i, &bytes, sizeof(bytes));
+      }
+      // Horizontal sums, the lanes cannot overflow for the size of a block
+      sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+      sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+      nulls = _mm_add_epi32(nulls, _mm_shuffle_epi32(nulls, _MM_SHUFFLE(1, 0, 3, 2)));
+      nulls = _mm_add_epi32(nulls, _mm_shuffle_epi32(nulls, _MM_SHUFFLE(2, 3, 0, 1)));
+      total = (size_t)_mm_cvtsi128_si32(sum) + (size_t)_mm_cvtsi128_si32(nulls) * char_size(NULL_VALUE);
+   }
+#endif
+   for (; i < size; i++)
+   {
+      const void *const value = values + i * elementSize;
+      if (IsNumberNull(value, type, nullValue))
+      {
+         lengths[i] = 0;
+         total += char_size(NULL_VALUE);
+      }
+      else
+      {
+         lengths[i] = (uint8_t)GetNumLength(value, type);
+         total += lengths[i];
+      }
+   }
+   return total;
+}
+
+#if KJSON_SSE2
+static __m128i LoadLanes4(const char *const value, const NumberType_e type)
+{
+   // Widens 4 elements of up to 32 bits to 32-bit lanes
+   const __m128i zero = _mm_setzero_si128();
+   int32_t narrow;
+   __m128i lanes;
+   switch (type)
+   {
+      case eSigned8:
+         memcpy(&narrow, value, sizeof(narrow));
+         lanes = _mm_cvtsi32_si128(narrow);
+         lanes = _mm_unpacklo_epi8(lanes, lanes);
+         return _mm_srai_epi32(_mm_unpacklo_epi16(lanes, lanes), 24);
+      case eUnsigned8:
+         memcpy(&narrow, value, sizeof(narrow));
+         return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(narrow), zero), zero);
+      case eSigned16:
+         lanes = _mm_loadl_epi64((const __m128i *)(const void *)value);
+         return _mm_srai_epi32(_mm_unpacklo_epi16(lanes, lanes), 16);
+      case eUnsigned16:
+         return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(const void *)value), zero);
+      default:
+         return _mm_loadu_si128((const __m128i *)(const void *)value);
+   }
+}
+
+static __m128i CountDigits4(const __m128i lanes, const bool isSigned)
+{
+   // The magnitude is compared against 10^1 - 1 to 10^9 - 1, each match adds
+   // a digit, and the sign adds a byte. SSE2 only compares signed lanes, so
+   // both sides are biased by 2^31 to compare them as unsigned
+   const __m128i sign = isSigned ? _mm_srai_epi32(lanes, 31) : _mm_setzero_si128();
+   const __m128i magnitude = _mm_xor_si128(_mm_sub_epi32(_mm_xor_si128(lanes, sign), sign), _mm_set1_epi32(INT32_MIN));
+   __m128i length = _mm_sub_epi32(_mm_set1_epi32(1), sign);
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[0])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[1])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[2])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[3])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[4])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[5])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[6])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[7])));
+   length = _mm_sub_epi32(length, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(digitThresholds[8])));
+   return length;
+}
+#endif
+
+#if KJSON_AVX2
+static __m256i LoadLanes8(const char *const value, const NumberType_e type)
+{
+   // Widens 8 elements of up to 32 bits to 32-bit lanes
+   switch (type)
+   {
+      case eSigned8:
+         return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(const void *)value));
+      case eUnsigned8:
+         return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(const void *)value));
+      case eSigned16:
+         return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(const void *)value));
+      case eUnsigned16:
+         return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(const void *)value));
+      default:
+         return _mm256_loadu_si256((const __m256i *)(const void *)value);
+   }
+}
+
+static __m256i CountDigits8(const __m256i lanes, const bool isSigned)
+{
+   // Same as CountDigits4, 8 lanes at a time
+   const __m256i sign = isSigned ? _mm256_srai_epi32(lanes, 31) : _mm256_setzero_si256();
+   const __m256i magnitude = _mm256_xor_si256(_mm256_sub_epi32(_mm256_xor_si256(lanes, sign), sign), _mm256_set1_epi32(INT32_MIN));
+   __m256i length = _mm256_sub_epi32(_mm256_set1_epi32(1), sign);
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[0])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[1])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[2])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[3])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[4])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[5])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[6])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[7])));
+   length = _mm256_sub_epi32(length, _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(digitThresholds[8])));
+   return length;
+}
+#endif
+
+static int32_t LoadSigned(const void *const value, const NumberType_e type)
+{
+   // Narrow elements are read in place and widened one at a time
+   switch (type)
+   {
+      case eSigned8:
+         return *(const int8_t *)value;
+      case eSigned16:
+         return *(const int16_t *)value;
+      case eSigned32:
+         return *(const int32_t *)value;
+      default:
+         return (int32_t) * (const int *)value;
+   }
+}
+
+static uint32_t LoadUnsigned(const void *const value, const NumberType_e type)
+{
+   switch (type)
+   {
+      case eUnsigned8:
+         return *(const uint8_t *)value;
+      case eUnsigned16:
+         return *(const uint16_t *)value;
+      case eUnsigned32:
+         return *(const uint32_t *)value;
+      default:
+         return (uint32_t) * (const unsigned int *)value;
+   }
+}
+
+static size_t FindEscape(const char *const string, const size_t length, const bool ascii)
+{
+   // Returns the index of the first '"', '\\' or control character, or of the
+   // first non-ASCII byte if ascii is set, or length.
+   // Clean blocks are skipped 32 or 16 bytes at a time
+   size_t i = 0;
+#if KJSON_AVX2
+   const __m256i quote32 = _mm256_set1_epi8('"');
+   const __m256i backslash32 = _mm256_set1_epi8('\\');
+   const __m256i control32 = _mm256_set1_epi8(0x1F);
+   for (; i + 32 <= length; i += 32)
+   {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i *)(const void *)(string + i));
+      const __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)),
+                                              _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control32), chunk));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+      if (ascii)
+      {
+         mask |= (uint32_t)_mm256_movemask_epi8(chunk);
+      }
+      if (mask)
+      {
+         return i + (size_t)__builtin_ctz(mask);
+      }
+   }
+#endif
+#if KJSON_SSE2
+   const __m128i quote = _mm_set1_epi8('"');
+   const __m128i backslash = _mm_set1_epi8('\\');
+   const __m128i control = _mm_set1_epi8(0x1F);
+   for (; i + 16 <= length; i += 16)
+   {
+      const __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)(string + i));
+      const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                           _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+      uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+      if (ascii)
+      {
+         mask |= (uint32_t)_mm_movemask_epi8(chunk);
+      }
+      if (mask)
+      {
+         return i + (size_t)__builtin_ctz(mask);
+      }
+   }
+#endif
+   for (; i < length; i++)
+   {
+      const unsigned char c = (unsigned char)string[i];
+      if ((c < 0x20) || ('"' == c) || ('\\' == c) || (ascii && (c >= 0x80)))
+      {
+         return i;
+      }
+   }
+   return length;
+}
+
+static void ScanWindow(Scanner_t *const scanner, const size_t base)
+{
+   // Classifies the 64 bytes from base. The end of the input is padded with a
+   // byte that is in neither set. '[' and ']' are folded onto '{' and '}' by
+   // setting bit 5, whitespace is any byte up to ' '
+   const char *string = scanner->json + base;
+   char padded[SCAN_WINDOW];
+   if (scanner->length - base < SCAN_WINDOW)
+   {
+      memset(padded, 'a', sizeof(padded));
+      memcpy(padded, string, scanner->length - base);
+      string = padded;
+   }
+   uint64_t structural = 0;
+   uint64_t quotes = 0;
+#if KJSON_AVX2
+   const __m256i quote32 = _mm256_set1_epi8('"');
+   const __m256i backslash32 = _mm256_set1_epi8('\\');
+   const __m256i comma32 = _mm256_set1_epi8(',');
+   const __m256i colon32 = _mm256_set1_epi8(':');
+   const __m256i space32 = _mm256_set1_epi8(' ');
+   const __m256i open32 = _mm256_set1_epi8('{');
+   const __m256i close32 = _mm256_set1_epi8('}');
+   for (unsigned int i = 0; i < SCAN_WINDOW; i += 32)
+   {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i *)(const void *)(string + i));
+      const __m256i folded = _mm256_or_si256(chunk, space32);
+      const __m256i quote = _mm256_cmpeq_epi8(chunk, quote32);
+      const __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(quote, _mm256_cmpeq_epi8(chunk, comma32)),
+                                                              _mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon32), _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, space32), chunk))),
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(folded, open32), _mm256_cmpeq_epi8(folded, close32)));
+      structural |= (uint64_t)(uint32_t)_mm256_movemask_epi8(special) << i;
+      quotes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(quote, _mm256_cmpeq_epi8(chunk, backslash32))) << i;
+   }
+#elif KJSON_SSE2
+   const __m128i quote16 = _mm_set1_epi8('"');
+   const __m128i backslash16 = _mm_set1_epi8('\\');
+   const __m128i comma16 = _mm_set1_epi8(',');
+   const __m128i colon16 = _mm_set1_epi8(':');
+   const __m128i space16 = _mm_set1_epi8(' ');
+   const __m128i open16 = _mm_set1_epi8('{');
+   const __m128i close16 = _mm_set1_epi8('}');
+   for (unsigned int i = 0; i < SCAN_WINDOW; i += 16)
+   {
+      const __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)(string + i));
+      const __m128i folded = _mm_or_si128(chunk, space16);
+      const __m128i quote = _mm_cmpeq_epi8(chunk, quote16);
+      const __m128i special = _mm_or_si128(_mm_or_si128(_mm_or_si128(quote, _mm_cmpeq_epi8(chunk, comma16)),
+                                                        _mm_or_si128(_mm_cmpeq_epi8(chunk, colon16), _mm_cmpeq_epi8(_mm_min_epu8(chunk, space16), chunk))),
+                                           _mm_or_si128(_mm_cmpeq_epi8(folded, open16), _mm_cmpeq_epi8(folded, close16)));
+      structural |= (uint64_t)(uint32_t)_mm_movemask_epi8(special) << i;
+      quotes |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_or_si128(quote, _mm_cmpeq_epi8(chunk, backslash16))) << i;
+   }
+#else
+   for (unsigned int i = 0; i < SCAN_WINDOW; i++)
+   {
+      const unsigned char c = (unsigned char)string[i];
+      const unsigned char folded = c | ' ';
+      const bool quote = ('"' == c);
+      structural |= (uint64_t)((c <= ' ') || quote || (',' == c) || (':' == c) || ('{' == folded) || ('}' == folded)) << i;
+      quotes |= (uint64_t)(quote || ('\\' == c)) << i;
+   }
+#endif
+   scanner->base = base;
+   scanner->structural = structural;
+   scanner->quotes = quotes;
+}
+
+static size_t FindNext(Scanner_t *const scanner, size_t i, const bool inString)
+{
+   // Returns the index of the next structural character from i, or of the next
+   // '"' or '\\' in a string, or length. Each window is classified once and its
+   // characters are then found with a bit scan
+   while (i < scanner->length)
+   {
+      if (i - scanner->base >= SCAN_WINDOW)
+      {
+         ScanWindow(scanner, i);
+      }
+      const uint64_t mask = (inString ? scanner->quotes : scanner->structural) >> (i - scanner->base);
+      if (mask)
+      {
+         return i + (size_t)__builtin_ctzll(mask);
+      }
+      i = scanner->base + SCAN_WINDOW;
+   }
+   return scanner->length;
+}
+
+static size_t SkipString(Scanner_t *const scanner, size_t i)
+{
+   // Returns the index after the closing quote of the string starting at i,
+   // or length if it is not closed
+   while (i < scanner->length)
+   {
+      i = FindNext(scanner, i, true);
+      if ((i < scanner->length) && ('"' == scanner->json[i]))
+      {
+         return i + 1;
+      }
+      i += char_size("\\\"");
+   }
+   return scanner->length;
+}
+
+static bool IsInlineArray(Scanner_t *const scanner, size_t i)
+{
+   // Arrays of values are written on one line, as kJSON_InsertArray... writes
+   // them, arrays of objects have a line per entry
+   while (i < scanner->length)
+   {
+      i = FindNext(scanner, i, false);
+      if (i >= scanner->length)
+      {
+         break;
+      }
+      const char c = scanner->json[i++];
+      if ('"' == c)
+      {
+         i = SkipString(scanner, i);
+      }
+      else if (('{' == c) || ('[' == c) || ('}' == c))
+      {
+         return false;
+      }
+      else if (']' == c)
+      {
+         return true;
+      }
+   }
+   return true;
+}
+
+static void Emit(Output_t *const output, const char *const data, const size_t length)
+{
+   // The output past the end of the buffer is only counted. Moved rather than
+   // copied, the input and output can overlap when minifying in place
+   if (output->buffer && (length <= output->bufferSize) && (output->size <= output->bufferSize - length))
+   {
+      memmove(output->buffer + output->size, data, length);
+   }
+   output->size += length;
+}
+
+static void EmitLine(Output_t *const output, const char *const newLine, const size_t newLineLength, const size_t depth)
+{
+   Emit(output, newLine, newLineLength);
+   if (output->buffer && (depth <= output->bufferSize) && (output->size <= output->bufferSize - depth))
+   {
+      memset(output->buffer + output->size, '\t', depth);
+   }
+   output->size += depth;
+}
+
+static size_t EndOutput(Output_t *const output)
+{
+   // Size of the output, 0 and an empty buffer if it does not fit with its terminator
+   if (!output->buffer)
+   {
+      return output->size;
+   }
+   if (output->size >= output->bufferSize)
+   {
+      if (output->bufferSize)
+      {
+         output->buffer[0] = '\0';
+      }
+      return 0;
+   }
+   output->buffer[output->size] = '\0';
+   return output->size;
+}
+
+#if !CONFIG_KJSON_NO_RAW_CHECK
+static bool CheckRaw(const char *const json, const size_t length, const bool ascii)
+{
+   // Structural check of a raw value: one value, strings closed, brackets
+   // matched up to 64 levels deep. String bodies are skipped with the escape
+   // scan, the brackets are kept on a bit stack (1 for an array)
+   uint64_t stack = 0;
+   size_t depth = 0;
+   bool started = false;
+   bool inLiteral = false;
+   for (size_t i = 0; i < length; i++)
+   {
+      const unsigned char c = (unsigned char)json[i];
+      if ((' ' == c) || ('\t' == c) || ('\n' == c) || ('\r' == c))
+      {
+         inLiteral = false;
+         continue;
+      }
+      if ((c < 0x20) || (ascii && (c >= 0x80)))
+      {
+         return false;
+      }
+      const bool opens = ('"' == c) || ('{' == c) || ('[' == c);
+      if (!depth && started && (opens || !inLiteral))
+      {
+         return false;
+      }
+      started = true;
+      if ('"' == c)
+      {
+         // A backslash and the character it escapes are skipped together
+         for (i++; i < length; i += 2)
+         {
+            i += FindEscape(json + i, length - i, ascii);
+            if ((i < length) && ('\\' != json[i]))
+            {
+               break;
+            }
+         }
+         if ((i >= length) || ('"' != json[i]))
+         {
+            return false;
+         }
+      }
+      else if (('{' == c) || ('[' == c))
+      {
+         if (depth == 64)
+         {
+            return false;
+         }
+         stack = (stack << 1) | ('[' == c);
+         depth++;
+      }
+      else if (('}' == c) || (']' == c))
+      {
+         if (!depth || ((stack & 1) != (']' == c)))
+         {
+            return false;
+         }
+         stack >>= 1;
+         depth--;
+      }
+      else if (!depth)
+      {
+         if ((',' == c) || (':' == c))
+         {
+            return false;
+         }
+         inLiteral = true;
+      }
+   }
+   return started && !depth;
+}
+#endif
+
+static size_t DecodeUtf8(const char *const string, const size_t length, uint32_t *const codePoint)
+{
+   // Returns the number of bytes consumed. Invalid sequences set the code
+   // point to UTF8_INVALID and consume their longest valid prefix, or one byte
+   const unsigned char *const bytes = (const unsigned char *)string;
+   const unsigned char lead = bytes[0];
+   unsigned char low = 0x80;
+   unsigned char high = 0xBF;
+   size_t count;
+   uint32_t value;
+   *codePoint = UTF8_INVALID;
+   if (lead < 0x80)
+   {
+      *codePoint = lead;
+      return 1;
+   }
+   else if (lead < 0xC2)
+   {
+      return 1;
+   }
+   else if (lead < 0xE0)
+   {
+      count = 2;
+      value = lead & 0x1Fu;
+   }
+   else if (lead < 0xF0)
+   {
+      count = 3;
+      value = lead & 0x0Fu;
+      low = (0xE0 == lead) ? 0xA0 : low;   // Overlong
+      high = (0xED == lead) ? 0x9F : high; // Surrogates
+   }
+   else if (lead < 0xF5)
+   {
+      count = 4;
+      value = lead & 0x07u;
+      low = (0xF0 == lead) ? 0x90 : low;   // Overlong
+      high = (0xF4 == lead) ? 0x8F : high; // Above U+10FFFF
+   }
+   else
+   {
+      return 1;
+   }
+   for (size_t i = 1; i < count; i++)
+   {
+      if ((i >= length) || (bytes[i] < low) || (bytes[i] > high))
+      {
+         return i;
+      }
+      value = (value << 6) | (bytes[i] & 0x3Fu);
+      low = 0x80;
+      high = 0xBF;
+   }
+   *codePoint = value;
+   return count;
+}
+
+static size_t WriteUnicodeEscape(char *const string, const uint32_t unit)
+{
+   string[0] = '\\';
+   string[1] = 'u';
+   string[2] = hexDigits[(unit >> 12) & 0xF];
+   string[3] = hexDigits[(unit >> 8) & 0xF];
+   string[4] = hexDigits[(unit >> 4) & 0xF];
+   string[5] = hexDigits[unit & 0xF];
+   return char_size("\\uXXXX");
+}
+
+static size_t WriteEscaped(char *const string, size_t space, const char *const value, const kjson_ascii_e ascii)
+{
+   // Runs without special characters are copied as a block. Returns NO_FIT
+   // if space runs out, REJECTED_LENGTH for invalid UTF-8 under KJSON_ASCII_REJECT
+   char *end = string;
+   const size_t length = strlen(value);
+   size_t i = 0;
+   while (i < length)
+   {
+      const size_t run = FindEscape(value + i, length - i, KJSON_ASCII_OFF != ascii);
+      if (run > space)
+      {
+         return NO_FIT;
+      }
+      memcpy(end, value + i, run);
+      end += run;
+      space -= run;
+      i += run;
+      if (i >= length)
+      {
+         break;
+      }
+      const unsigned char c = (unsigned char)value[i];
+      if (c >= 0x80)
+      {
+         uint32_t codePoint;
+         i += DecodeUtf8(value + i, length - i, &codePoint);
+         if (UTF8_INVALID == codePoint)
+         {
+            if (KJSON_ASCII_REJECT == ascii)
+            {
+               return REJECTED_LENGTH;
+            }
+            codePoint = UTF8_REPLACEMENT;
+         }
+         const size_t bytes = (codePoint >= 0x10000) ? 2 * char_size("\\uXXXX") : char_size("\\uXXXX");
+         if (bytes > space)
+         {
+            return NO_FIT;
+         }
+         space -= bytes;
+         if (codePoint >= 0x10000)
+         {
+            codePoint -= 0x10000;
+            end += WriteUnicodeEscape(end, 0xD800 + (codePoint >> 10));
+            end += WriteUnicodeEscape(end, 0xDC00 + (codePoint & 0x3FF));
+         }
+         else
+         {
+            end += WriteUnicodeEscape(end, codePoint);
+         }
+         continue;
+      }
+      i++;
+      const size_t bytes = ((c < 0x20) && ('u' == escapeCodes[c])) ? char_size("\\uXXXX") : char_size("\\n");
+      if (bytes > space)
+      {
+         return NO_FIT;
+      }
+      space -= bytes;
+      if (c >= 0x20)
+      {
+         *(end++) = '\\';
+         *(end++) = (char)c;
+      }
+      else if ('u' != escapeCodes[c])
+      {
+         *(end++) = '\\';
+         *(end++) = escapeCodes[c];
+      }
+      else
+      {
+         end += WriteUnicodeEscape(end, c);
+      }
+   }
+   return (size_t)(end - string);
+}
+
+static size_t GetEscapedLength(const char *const value, const kjson_ascii_e ascii)
+{
+   // Returns REJECTED_LENGTH for invalid UTF-8 under KJSON_ASCII_REJECT
+   const size_t length = strlen(value);
+   size_t escaped = length;
+   size_t i = 0;
+   while ((i += FindEscape(value + i, length - i, KJSON_ASCII_OFF != ascii)) < length)
+   {
+      const unsigned char c = (unsigned char)value[i];
+      if (c >= 0x80)
+      {
+         uint32_t codePoint;
+         const size_t bytes = DecodeUtf8(value + i, length - i, &codePoint);
+         if ((UTF8_INVALID == codePoint) && (KJSON_ASCII_REJECT == ascii))
+         {
+            return REJECTED_LENGTH;
+         }
+         escaped -= bytes;
+         escaped += ((UTF8_INVALID != codePoint) && (codePoint >= 0x10000)) ? 2 * char_size("\\uXXXX") : char_size("\\uXXXX");
+         i += bytes;
+      }
+      else
+      {
+         escaped += ((c < 0x20) && ('u' == escapeCodes[c])) ? char_size("u00XX") : char_size("\\");
+         i++;
+      }
+   }
+   return escaped;
+}
+
+static size_t WriteBinary(char *const string, const uint8_t *const data, const size_t length, const BinaryType_e type)
+{
+   return (eHex == type) ? WriteHex(string, data, length) : WriteBase64(string, data, length);
+}
+
+static size_t WriteBase64(char *const string, const uint8_t *const data, const size_t length)
+{
+   // Every 3 bytes become 4 characters, the last group is padded with '='.
+   // Blocks of 24 or 12 bytes are encoded 32 or 16 characters at a time.
+   // The loads read 4 bytes past the block, the last bytes are left to the scalar loop
+   char *end = string;
+   size_t i = 0;
+#if KJSON_AVX2
+   for (; i + 28 <= length; i += 24)
+   {
+      const __m128i low = _mm_loadu_si128((const __m128i *)(const void *)(data + i));
+      const __m128i high = _mm_loadu_si128((const __m128i *)(const void *)(data + i + 12));
+      const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+      _mm256_storeu_si256((__m256i *)(void *)end, EncodeBase64Block32(bytes));
+      end += 32;
+   }
+#endif
+#if KJSON_SSSE3
+   for (; i + 16 <= length; i += 12)
+   {
+      const __m128i bytes = _mm_loadu_si128((const __m128i *)(const void *)(data + i));
+      _mm_storeu_si128((__m128i *)(void *)end, EncodeBase64Block16(bytes));
+      end += 16;
+   }
+#endif
+   for (; i + 3 <= length; i += 3)
+   {
+      const uint32_t group = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+      end[0] = base64Digits[group >> 18];
+      end[1] = base64Digits[(group >> 12) & 0x3F];
+      end[2] = base64Digits[(group >> 6) & 0x3F];
+      end[3] = base64Digits[group & 0x3F];
+      end += 4;
+   }
+   if (i < length)
+   {
+      const bool pair = (i + 1 < length);
+      const uint32_t group = ((uint32_t)data[i] << 16) | (pair ? ((uint32_t)data[i + 1] << 8) : 0);
+      end[0] = base64Digits[group >> 18];
+      end[1] = base64Digits[(group >> 12) & 0x3F];
+      end[2] = pair ? base64Digits[(group >> 6) & 0x3F] : '=';
+      end[3] = '=';
+      end += 4;
+   }
+   return (size_t)(end - string);
+}
+
+#if KJSON_SSSE3
+static __m128i EncodeBase64Block16(const __m128i bytes)
+{
+   // Each 3 byte group is spread over a 32-bit lane and its four 6-bit
+   // indices are moved into separate bytes with two multiplies (W. Mula's
+   // method). The indices are turned into characters by adding the offset of
+   // their range: 0-25 'A', 26-51 'a', 52-61 '0', 62 '+' and 63 '/'
+   const __m128i groups = _mm_shuffle_epi8(bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+   const __m128i high = _mm_mulhi_epu16(_mm_and_si128(groups, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+   const __m128i low = _mm_mullo_epi16(_mm_and_si128(groups, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+   const __m128i indices = _mm_or_si128(high, low);
+   const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                         '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+   __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+   range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+   return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+#endif
+
+#if KJSON_AVX2
+static __m256i EncodeBase64Block32(const __m256i bytes)
+{
+   // Same as EncodeBase64Block16, with 12 bytes in each 128-bit lane
+   const __m256i groups = _mm256_shuffle_epi8(bytes, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                                     10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+   const __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(groups, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+   const __m256i low = _mm256_mullo_epi16(_mm256_and_si256(groups, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+   const __m256i indices = _mm256_or_si256(high, low);
+   const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+   __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+   range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+   return _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+}
+#endif
+
+static size_t WriteHex(char *const string, const uint8_t *const data, const size_t length)
+{
+   // Lowercase, two digits per byte. The high and low nibbles of a block are
+   // looked up 16 at a time and interleaved, 32 or 16 bytes per step
+   char *end = string;
+   size_t i = 0;
+#if KJSON_AVX2
+   const __m256i digits32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)hexDigits));
+   const __m256i nibble32 = _mm256_set1_epi8(0x0F);
+   for (; i + 32 <= length; i += 32)
+   {
+      const __m256i bytes = _mm256_loadu_si256((const __m256i *)(const void *)(data + i));
+      const __m256i high = _mm256_shuffle_epi8(digits32, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble32));
+      const __m256i low = _mm256_shuffle_epi8(digits32, _mm256_and_si256(bytes, nibble32));
+      // The unpacks work within 128-bit lanes, bytes 0-7 and 16-23 then 8-15 and 24-31
+      const __m256i first = _mm256_unpacklo_epi8(high, low);
+      const __m256i second = _mm256_unpackhi_epi8(high, low);
+      _mm256_storeu_si256((__m256i *)(void *)end, _mm256_permute2x128_si256(first, second, 0x20));
+      _mm256_storeu_si256((__m256i *)(void *)(end + 32), _mm256_permute2x128_si256(first, second, 0x31));
+      end += 64;
+   }
+#endif
+#if KJSON_SSE2
+   const __m128i nibble = _mm_set1_epi8(0x0F);
+   for (; i + 16 <= length; i += 16)
+   {
+      const __m128i bytes = _mm_loadu_si128((const __m128i *)(const void *)(data + i));
+      const __m128i high = GetHexDigits16(_mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+      const __m128i low = GetHexDigits16(_mm_and_si128(bytes, nibble));
+      _mm_storeu_si128((__m128i *)(void *)end, _mm_unpacklo_epi8(high, low));
+      _mm_storeu_si128((__m128i *)(void *)(end + 16), _mm_unpackhi_epi8(high, low));
+      end += 32;
+   }
+#endif
+   for (; i < length; i++)
+   {
+      end[0] = hexDigits[data[i] >> 4];
+      end[1] = hexDigits[data[i] & 0x0F];
+      end += 2;
+   }
+   return (size_t)(end - string);
+}
+
+#if KJSON_SSE2
+static __m128i GetHexDigits16(const __m128i nibbles)
+{
+#if KJSON_SSSE3
+   return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)hexDigits), nibbles);
+#else
+   // Without a byte shuffle, the nibbles above 9 are moved from after '9' to 'a'
+   const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '9' - 1));
+   return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+#endif
+}
+#endif
+
+static size_t GetBinaryLength(const size_t length, const BinaryType_e type)
+{
+   // Base64 writes 4 characters for every 3 bytes or part of them
+   return (eHex == type) ? (2 * length) : (((length + 2) / 3) * 4);
+}
+
+static size_t GetStringLength(kjson_t *const jsonHandle, const char *const value)
+{
+   const size_t length = GetEscapedLength(value, jsonHandle->ascii);
+   if (REJECTED_LENGTH == length)
+   {
+      jsonHandle->rejected = true;
+   }
+   return length;
+}
+
+static size_t GetKeyLength(kjson_t *const jsonHandle, const kjson_key_t *const key)
+{
+   // Length of the escaped key, without its quotes and separator
+   if (key->length)
+   {
+      return key->length - char_size("\"") - char_size(KEY_END);
+   }
+   return GetStringLength(jsonHandle, key->text);
 }
 
-static size_t InsertNumber(char *const string, const char *const key, const int value)
+static size_t GetEntryLength(kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t valueSize)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, NUMBER, key, value);
-   return (size_t)(end - start);
+   // Newline, indentation, quoted key and key separator followed by the value
+   return GetLineLength(jsonHandle) + GetKeyLength(jsonHandle, key) + char_size("\"") + char_size(KEY_END) + GetKeySeparatorLength(jsonHandle) + valueSize;
 }
 
-static size_t InsertUnsignedNumber(char *const string, const char *const key, const unsigned int value)
+static bool NumberFits(kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t valueSize)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, UNSIGNED, key, value);
-   return (size_t)(end - start);
+   const bool fits = Reserve(jsonHandle, GetEntryLength(jsonHandle, key, valueSize + char_size(",")));
+   STATS_FITS(jsonHandle);
+   return fits;
 }
 
 #if !CONFIG_KJSON_NO_FLOAT
-static size_t InsertFloat(char *const string, const char *const key, const float value, const unsigned int decimals)
+static bool IsFloatFinite(const float value)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, FLOAT, key, decimals, value);
-   return (size_t)(end - start);
+   uint32_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+   return FLOAT_EXPONENT_MASK != ((bits >> FLOAT_MANTISSA_BITS) & FLOAT_EXPONENT_MASK);
 }
-#endif // CONFIG_KJSON_NO_FLOAT
 
-static size_t InsertBoolean(char *const string, const char *const key, bool value)
+static bool IsDoubleFinite(const double value)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, BOOLEAN, key, value ? BOOLEAN_TRUE : BOOLEAN_FALSE);
-   return (size_t)(end - start);
+   uint64_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+   return DOUBLE_EXPONENT_MASK != ((bits >> DOUBLE_MANTISSA_BITS) & DOUBLE_EXPONENT_MASK);
 }
 
-static size_t InsertNull(char *const string, const char *const key)
+static bool IsDoubleNull(const double value, const double nullValue)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, BOOLEAN, key, NULL_VALUE);
-   return (size_t)(end - start);
+   uint64_t bits;
+   uint64_t nullBits;
+   memcpy(&bits, &value, sizeof(bits));
+   memcpy(&nullBits, &nullValue, sizeof(nullBits));
+   return bits == nullBits;
 }
 
-static size_t InsertArrayNumber(char *const string, const char *const key, const void *const array, const size_t size, const NumberType_e type, void *const nullValue)
+static bool SplitValue(const void *const value, const FloatType_e type, const unsigned int decimals, const void *const nullValue, DecimalFloat_t *const decimal)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, ARRAY_KEY, key);
-   for (size_t i = 0; i < size; i++)
+   // Returns false if the value is to be inserted as null
+   if (eFloat == type)
    {
-      if (((int *)array)[i] == *(int *)nullValue)
-      {
-         end += sprintf(end, ARRAY_VALUE_NULL);
-      }
-      else if (eSigned == type)
+      const float num = *(const float *)value;
+      const float nullNum = *(const float *)nullValue;
+      if (IS_FLOAT_NULL(num, nullNum) || !IsFloatFinite(num))
       {
-         end += sprintf(end, ARRAY_VALUE_NUMBER, ((int *)array)[i]);
+         return false;
       }
-      else
+      SplitFloat(num, decimals, decimal);
+   }
+   else
+   {
+      const double num = *(const double *)value;
+      if (IsDoubleNull(num, *(const double *)nullValue) || !IsDoubleFinite(num))
       {
-         end += sprintf(end, ARRAY_VALUE_UNSIGNED, ((unsigned int *)array)[i]);
+         return false;
       }
+      SplitDouble(num, decimals, decimal);
    }
-   end -= ARRAY_TRIM;
-   end += sprintf(end, ARRAY_END);
-   return (size_t)(end - start);
+   return true;
 }
 
-static size_t InsertArrayFloat(char *const string, const char *const key, const float *const array, const size_t size, const unsigned int decimals, const float nullValue)
+static void SplitFloat(const float value, const unsigned int decimals, DecimalFloat_t *const decimal)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, ARRAY_KEY, key);
-   for (size_t i = 0; i < size; i++)
+   uint32_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+   const uint32_t biasedExponent = (bits >> FLOAT_MANTISSA_BITS) & FLOAT_EXPONENT_MASK;
+   uint64_t mantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+   int exponent = 1 - FLOAT_BIAS;
+   if (biasedExponent)
    {
-      end += sprintf(end, (IS_FLOAT_NULL(array[i], nullValue) ? ARRAY_VALUE_NULL : ARRAY_VALUE_FLOAT), decimals, array[i]);
+      mantissa |= 1u << FLOAT_MANTISSA_BITS;
+      exponent = (int)biasedExponent - FLOAT_BIAS;
    }
-   end -= ARRAY_TRIM;
-   end += sprintf(end, ARRAY_END);
-   return (size_t)(end - start);
-}
 
-static size_t InsertArrayString(char *const string, const char *const key, const char *const *const array, const size_t size)
-{
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, ARRAY_KEY, key);
-   for (size_t i = 0; i < size; i++)
+   decimal->negative = (bits >> 31) != 0;
+   decimal->shortest = (KJSON_DECIMALS_SHORTEST == decimals);
+   decimal->decimals = decimals < KJSON_MAX_DECIMALS ? decimals : KJSON_MAX_DECIMALS;
+   decimal->integer = 0;
+   decimal->fraction = 0;
+   decimal->mantissa = 0;
+   decimal->exponent = 0;
+   decimal->count = 0;
+
+   if (decimal->shortest)
    {
-      end += sprintf(end, array[i] ? ARRAY_VALUE_STRING : ARRAY_VALUE_NULL, array[i]);
+      decimal->decimals = 0;
+      ShortestFloat(bits, decimal);
+   }
+   else if (exponent > 40)
+   {
+      // At least 2^64, kept as mantissa and exponent
+      decimal->mantissa = mantissa;
+      decimal->exponent = exponent;
+   }
+   else if (exponent >= 0)
+   {
+      decimal->integer = mantissa << exponent;
+   }
+   else
+   {
+      SplitFraction(mantissa, (unsigned int)-exponent, decimal);
    }
-   end -= ARRAY_TRIM;
-   end += sprintf(end, ARRAY_END);
-   return (size_t)(end - start);
 }
 
-static size_t InitRoot(char *const string)
+static void SplitDouble(const double value, const unsigned int decimals, DecimalFloat_t *const decimal)
 {
-   char *const start = string;
-   char *end = start;
-   *(end++) = '{';
-   return (size_t)(end - start);
+   uint64_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+   const uint32_t biasedExponent = (uint32_t)(bits >> DOUBLE_MANTISSA_BITS) & DOUBLE_EXPONENT_MASK;
+   uint64_t mantissa = bits & ((1ull << DOUBLE_MANTISSA_BITS) - 1);
+   int exponent = 1 - DOUBLE_BIAS;
+   if (biasedExponent)
+   {
+      mantissa |= 1ull << DOUBLE_MANTISSA_BITS;
+      exponent = (int)biasedExponent - DOUBLE_BIAS;
+   }
+
+   decimal->negative = (bits >> 63) != 0;
+   decimal->shortest = (KJSON_DECIMALS_SHORTEST == decimals);
+   decimal->decimals = decimals < KJSON_MAX_DECIMALS ? decimals : KJSON_MAX_DECIMALS;
+   decimal->integer = 0;
+   decimal->fraction = 0;
+   decimal->mantissa = 0;
+   decimal->exponent = 0;
+   decimal->count = 0;
+
+   if (decimal->shortest)
+   {
+      decimal->decimals = 0;
+      ShortestDouble(mantissa, exponent, decimal);
+   }
+   else if (exponent > 11)
+   {
+      // At least 2^64, kept as mantissa and exponent
+      decimal->mantissa = mantissa;
+      decimal->exponent = exponent;
+   }
+   else if (exponent >= 0)
+   {
+      decimal->integer = mantissa << exponent;
+   }
+   else
+   {
+      SplitFraction(mantissa, (unsigned int)-exponent, decimal);
+   }
 }
 
-static size_t Trim(char *const string)
+static void SplitFraction(const uint64_t mantissa, const unsigned int shift, DecimalFloat_t *const decimal)
 {
-   const char *const start = string;
-   const char *const end = start - 1;
-   if (',' == *end)
+   // mantissa / 2^shift is scaled by 10^decimals in 128 bits and rounded
+   // half to even, matching the exact binary value
+   const uint64_t scale = powersOf10[decimal->decimals];
+   uint64_t integer = 0;
+   uint64_t scaled = 0;
+   int compare = -1; // Sign of the remainder minus one half
+   if (shift < 64)
    {
-      return (size_t)-1;
+      const uint64_t mask = (1ull << shift) - 1;
+      const uint64_t half = 1ull << (shift - 1);
+      uint64_t high;
+      const uint64_t low = Multiply64(mantissa & mask, scale, &high);
+      const uint64_t remainder = low & mask;
+      integer = mantissa >> shift;
+      scaled = (low >> shift) | (high << (64 - shift));
+      compare = (remainder > half) - (remainder < half);
    }
-   return 0;
+   else if (shift < 128)
+   {
+      const unsigned int highShift = shift - 64;
+      uint64_t high;
+      const uint64_t low = Multiply64(mantissa, scale, &high);
+      scaled = high >> highShift;
+      if (0 == highShift)
+      {
+         compare = (low > (1ull << 63)) - (low < (1ull << 63));
+      }
+      else
+      {
+         const uint64_t remainder = high & ((1ull << highShift) - 1);
+         const uint64_t half = 1ull << (highShift - 1);
+         compare = (remainder == half) ? (0 != low) : ((remainder > half) ? 1 : -1);
+      }
+   }
+   const uint64_t last = decimal->decimals ? scaled : integer;
+   if ((compare > 0) || ((0 == compare) && (last & 1)))
+   {
+      scaled++;
+   }
+   if (scaled == scale)
+   {
+      integer++;
+      scaled = 0;
+   }
+   decimal->integer = integer;
+   decimal->fraction = (uint32_t)scaled;
 }
 
-static size_t ExitRoot(char *const string)
+static uint64_t Multiply64(const uint64_t a, const uint64_t b, uint64_t *const high)
 {
-   char *const start = string;
-   char *end = start;
-   *(end++) = '}';
-   *(end++) = '\0';
-   return (size_t)(end - start);
+#if defined(__SIZEOF_INT128__)
+   const unsigned __int128 product = (unsigned __int128)a * b;
+   *high = (uint64_t)(product >> 64);
+   return (uint64_t)product;
+#else
+   const uint64_t aLow = (uint32_t)a;
+   const uint64_t aHigh = a >> 32;
+   const uint64_t bLow = (uint32_t)b;
+   const uint64_t bHigh = b >> 32;
+   const uint64_t lowLow = aLow * bLow;
+   const uint64_t lowHigh = aLow * bHigh;
+   const uint64_t highLow = aHigh * bLow;
+   const uint64_t middle = (lowLow >> 32) + (uint32_t)lowHigh + (uint32_t)highLow;
+   *high = aHigh * bHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+   return (middle << 32) | (uint32_t)lowLow;
+#endif
 }
 
-static size_t EnterObject(char *const string, const char *const key)
+static size_t WriteLargeInteger(char *const string, const uint64_t mantissa, const int exponent)
 {
-   char *const start = string;
-   char *end = start;
-   if (!key) end += sprintf(end, OBJECT_KEYLESS);
-   else end += sprintf(end, OBJECT_KEY, key);
-   return (size_t)(end - start);
+   // The value is at most 1024 bits wide, converted 9 digits at a time by
+   // long division of its 32 bit words
+   uint32_t words[33] = {0};
+   const size_t index = (size_t)exponent / 32;
+   const unsigned int shift = (unsigned int)exponent % 32;
+   words[index] = (uint32_t)(mantissa << shift);
+   words[index + 1] = (uint32_t)((mantissa << shift) >> 32);
+   words[index + 2] = shift ? (uint32_t)(mantissa >> (64 - shift)) : 0;
+   size_t used = index + 3;
+
+   char digits[320];
+   char *end = digits + sizeof(digits);
+   while (used && (0 == words[used - 1]))
+   {
+      used--;
+   }
+   do
+   {
+      uint64_t remainder = 0;
+      for (size_t i = used; i-- > 0;)
+      {
+         const uint64_t current = (remainder << 32) | words[i];
+         words[i] = (uint32_t)(current / powersOf10[9]);
+         remainder = current % powersOf10[9];
+      }
+      while (used && (0 == words[used - 1]))
+      {
+         used--;
+      }
+      const size_t length = used ? 9 : GetNumDigits((uint32_t)remainder);
+      end -= length;
+      WriteUnsigned(end, (uint32_t)remainder, length);
+   } while (used);
+
+   const size_t length = (size_t)(digits + sizeof(digits) - end);
+   if (string)
+   {
+      memcpy(string, end, length);
+   }
+   return length;
 }
 
-static size_t ExitObject(char *const string)
+static bool IsMultipleOfPow5(uint64_t value, const uint32_t q)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, OBJECT_END);
-   return (size_t)(end - start);
+   // Bounded by q, a value of 0 is a multiple of any power
+   for (uint32_t i = 0; i < q; i++)
+   {
+      if (0 != value % 5)
+      {
+         return false;
+      }
+      value /= 5;
+   }
+   return true;
 }
 
-static size_t EnterArray(char *const string, const char *const key)
+static uint32_t MulShift32(const uint32_t value, const uint64_t factor, const int32_t shift)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, ARRAY_KEY, key);
-   return (size_t)(end - start);
+   const uint64_t low = (uint64_t)value * (uint32_t)factor;
+   const uint64_t high = (uint64_t)value * (uint32_t)(factor >> 32);
+   return (uint32_t)(((low >> 32) + high) >> (shift - 32));
 }
 
-static size_t ExitArray(char *const string)
+static int32_t Pow5Bits(const int32_t exponent)
 {
-   char *const start = string;
-   char *end = start;
-   end += sprintf(end, ARRAY_END);
-   return (size_t)(end - start);
+   // ceil(log2(5^exponent)), 1 for an exponent of 0
+   return (int32_t)(((uint32_t)exponent * 1217359) >> 19) + 1;
 }
 
-static size_t InsertDepth(char *const string, const char *const newLine, const int depth)
+static void ShortestFloat(const uint32_t bits, DecimalFloat_t *const decimal)
 {
-#if CONFIG_KJSON_SMALLEST
-   unused(string);
-   unused(newLine);
-   unused(depth);
-   return 0;
-#else
-   char *const start = string;
-   char *end = start;
-   const size_t newLineLength = strlen(newLine);
-   for (size_t i = 0; i < newLineLength; i++)
+   // Ryu: the interval of decimals that round to the float is computed
+   // with 64 bit multiplications, then the digits shared by both ends are kept
+   const uint32_t biasedExponent = (bits >> FLOAT_MANTISSA_BITS) & FLOAT_EXPONENT_MASK;
+   const uint32_t ieeeMantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+   if ((0 == biasedExponent) && (0 == ieeeMantissa))
    {
-      *(end++) = newLine[i];
+      decimal->digits[0] = '0';
+      decimal->count = 1;
+      decimal->exponent = 0;
+      return;
    }
-   for (size_t i = 0; i < (size_t)depth; i++)
+
+   int32_t e2 = 1 - FLOAT_BIAS - 2;
+   uint32_t m2 = ieeeMantissa;
+   if (biasedExponent)
    {
-      *(end++) = '\t';
+      e2 = (int32_t)biasedExponent - FLOAT_BIAS - 2;
+      m2 |= 1u << FLOAT_MANTISSA_BITS;
    }
-   return (size_t)(end - start);
-#endif // CONFIG_KJSON_SMALLEST
-}
+   const bool acceptBounds = (0 == (m2 & 1));
 
-static void StartEntry(kjson_t *const jsonHandle)
-{
-   const size_t bytes = InsertDepth(jsonHandle->tail, jsonHandle->newLine, jsonHandle->depth);
-   jsonHandle->size += bytes;
-   jsonHandle->tail += bytes;
-}
+   const uint32_t mv = 4 * m2;
+   const uint32_t mp = 4 * m2 + 2;
+   const uint32_t mmShift = (0 != ieeeMantissa) || (biasedExponent <= 1);
+   const uint32_t mm = 4 * m2 - 1 - mmShift;
 
-static size_t GetNumDigits(const void *const value, const NumberType_e type)
-{
-   size_t count = 1;
-   long long num = 0;
-   if (eSigned == type)
+   uint32_t vr;
+   uint32_t vp;
+   uint32_t vm;
+   int32_t e10;
+   bool vmIsTrailingZeros = false;
+   bool vrIsTrailingZeros = false;
+   uint32_t lastRemovedDigit = 0;
+   uint32_t output;
+   if (e2 >= 0)
    {
-      num = *(int *)value;
+      const uint32_t q = ((uint32_t)e2 * 78913) >> 18; // log10(2^e2)
+      e10 = (int32_t)q;
+      const int32_t k = FLOAT_POW5_INV_BITCOUNT + Pow5Bits((int32_t)q) - 1;
+      const int32_t i = -e2 + (int32_t)q + k;
+      vr = MulShift32(mv, floatPow5InvSplit[q], i);
+      vp = MulShift32(mp, floatPow5InvSplit[q], i);
+      vm = MulShift32(mm, floatPow5InvSplit[q], i);
+      if ((0 != q) && ((vp - 1) / 10 <= vm / 10))
+      {
+         const int32_t l = FLOAT_POW5_INV_BITCOUNT + Pow5Bits((int32_t)q - 1) - 1;
+         lastRemovedDigit = MulShift32(mv, floatPow5InvSplit[q - 1], -e2 + (int32_t)q - 1 + l) % 10;
+      }
+      if (q <= 9)
+      {
+         // Only one of mp, mv and mm can be a multiple of 5, if any
+         if (0 == mv % 5)
+         {
+            vrIsTrailingZeros = IsMultipleOfPow5(mv, q);
+         }
+         else if (acceptBounds)
+         {
+            vmIsTrailingZeros = IsMultipleOfPow5(mm, q);
+         }
+         else
+         {
+            vp -= IsMultipleOfPow5(mp, q);
+         }
+      }
    }
    else
    {
-      num = *(unsigned int *)value;
+      const uint32_t q = ((uint32_t)-e2 * 732923) >> 20; // log10(5^-e2)
+      e10 = (int32_t)q + e2;
+      const int32_t i = -e2 - (int32_t)q;
+      const int32_t k = Pow5Bits(i) - FLOAT_POW5_BITCOUNT;
+      int32_t j = (int32_t)q - k;
+      vr = MulShift32(mv, floatPow5Split[i], j);
+      vp = MulShift32(mp, floatPow5Split[i], j);
+      vm = MulShift32(mm, floatPow5Split[i], j);
+      if ((0 != q) && ((vp - 1) / 10 <= vm / 10))
+      {
+         j = (int32_t)q - 1 - (Pow5Bits(i + 1) - FLOAT_POW5_BITCOUNT);
+         lastRemovedDigit = MulShift32(mv, floatPow5Split[i + 1], j) % 10;
+      }
+      if (q <= 1)
+      {
+         // mv = 4 * m2 always has at least two trailing zero bits
+         vrIsTrailingZeros = true;
+         if (acceptBounds)
+         {
+            vmIsTrailingZeros = (1 == mmShift);
+         }
+         else
+         {
+            vp--;
+         }
+      }
+      else if (q < 31)
+      {
+         vrIsTrailingZeros = 0 == (mv & ((1u << (q - 1)) - 1));
+      }
    }
-   if (num)
+
+   int32_t removed = 0;
+   if (vmIsTrailingZeros || vrIsTrailingZeros)
    {
-      count = 0;
-      while (0 != num)
+      while (vp / 10 > vm / 10)
+      {
+         vmIsTrailingZeros &= (0 == vm % 10);
+         vrIsTrailingZeros &= (0 == lastRemovedDigit);
+         lastRemovedDigit = vr % 10;
+         vr /= 10;
+         vp /= 10;
+         vm /= 10;
+         removed++;
+      }
+      if (vmIsTrailingZeros)
       {
-         num /= 10;
-         count++;
+         while (0 == vm % 10)
+         {
+            vrIsTrailingZeros &= (0 == lastRemovedDigit);
+            lastRemovedDigit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+         }
       }
-      if ((eSigned == type) && (*(int *)value < 0))
+      if (vrIsTrailingZeros && (5 == lastRemovedDigit) && (0 == vr % 2))
       {
-         count++;
+         // Exact halfway, round to even
+         lastRemovedDigit = 4;
       }
+      output = vr + (((vr == vm) && (!acceptBounds || !vmIsTrailingZeros)) || (lastRemovedDigit >= 5));
    }
-   return count;
+   else
+   {
+      while (vp / 10 > vm / 10)
+      {
+         lastRemovedDigit = vr % 10;
+         vr /= 10;
+         vp /= 10;
+         vm /= 10;
+         removed++;
+      }
+      output = vr + ((vr == vm) || (lastRemovedDigit >= 5));
+   }
+   decimal->count = GetNumDigits(output);
+   decimal->exponent = e10 + removed;
+   WriteUnsigned(decimal->digits, output, decimal->count);
 }
 
-static bool StringFits(kjson_t *const jsonHandle, const char *const key, const char *const value)
+static void ComputePow5(const uint32_t i, uint64_t *const result)
 {
-   const size_t size = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + strlen(value) + char_size(STRING) - char_size("%s") - char_size("%s");
-   return (jsonHandle->size + size <= jsonHandle->rootSize);
+   // 5^i truncated to DOUBLE_POW5_BITCOUNT bits, from the table entry below times a small power of 5
+   const uint32_t base = i / DOUBLE_POW5_TABLE_SIZE;
+   const uint32_t offset = i - base * DOUBLE_POW5_TABLE_SIZE;
+   const uint64_t *const split = doublePow5Split[base];
+   if (0 == offset)
+   {
+      result[0] = split[0];
+      result[1] = split[1];
+      return;
+   }
+   uint64_t high1;
+   uint64_t high0;
+   const uint64_t low1 = Multiply64(doublePow5Table[offset], split[1], &high1);
+   const uint64_t low0 = Multiply64(doublePow5Table[offset], split[0], &high0);
+   const uint64_t sum = high0 + low1;
+   high1 += (sum < high0);
+   const uint32_t shift = (uint32_t)(Pow5Bits((int32_t)i) - Pow5Bits((int32_t)(base * DOUBLE_POW5_TABLE_SIZE)));
+   result[0] = ((sum << (64 - shift)) | (low0 >> shift)) + ((doublePow5Offsets[i / 16] >> ((i % 16) << 1)) & 3);
+   result[1] = (high1 << (64 - shift)) | (sum >> shift);
 }
 
-static bool NumberFits(kjson_t *const jsonHandle, const char *const key, const void *const value, const NumberType_e type)
+static void ComputeInvPow5(const uint32_t i, uint64_t *const result)
 {
-   const size_t valueSize = GetNumDigits(value, type);
-   const size_t size = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + valueSize + char_size(NUMBER) - char_size("%s") - char_size("%d");
-   return (jsonHandle->size + size <= jsonHandle->rootSize);
+   // Inverse of 5^i as in doublePow5InvSplit, from the table entry above times a small power of 5
+   const uint32_t base = (i + DOUBLE_POW5_TABLE_SIZE - 1) / DOUBLE_POW5_TABLE_SIZE;
+   const uint32_t offset = base * DOUBLE_POW5_TABLE_SIZE - i;
+   const uint64_t *const split = doublePow5InvSplit[base];
+   if (0 == offset)
+   {
+      result[0] = split[0] + 1;
+      result[1] = split[1];
+      return;
+   }
+   uint64_t high1;
+   uint64_t high0;
+   const uint64_t low1 = Multiply64(doublePow5Table[offset], split[1], &high1);
+   const uint64_t low0 = Multiply64(doublePow5Table[offset], split[0], &high0);
+   const uint64_t sum = high0 + low1;
+   high1 += (sum < high0);
+   const uint32_t shift = (uint32_t)(Pow5Bits((int32_t)(base * DOUBLE_POW5_TABLE_SIZE)) - Pow5Bits((int32_t)i));
+   result[0] = ((sum << (64 - shift)) | (low0 >> shift)) + 1 + ((doublePow5InvOffsets[i / 16] >> ((i % 16) << 1)) & 3);
+   result[1] = (high1 << (64 - shift)) | (sum >> shift);
 }
 
-#if !CONFIG_KJSON_NO_FLOAT
-static bool FloatFits(kjson_t *const jsonHandle, const char *const key, const float value, const unsigned int decimals)
+static uint64_t MulShift64(const uint64_t value, const uint64_t *const factor, const int32_t shift)
 {
-   const int intVal = (int)value;
-   const size_t valueSize = GetNumDigits(&intVal, eSigned) + char_size(".") + decimals;
-   const size_t size = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + valueSize + char_size(FLOAT) - char_size("%s") - char_size("%.*f");
-   return (jsonHandle->size + size <= jsonHandle->rootSize);
+   // Bits 64 to 127 of the 192 bit product are all that is needed, the shift is between 64 and 128
+   uint64_t high1;
+   uint64_t high0;
+   const uint64_t low1 = Multiply64(value, factor[1], &high1);
+   Multiply64(value, factor[0], &high0);
+   const uint64_t sum = high0 + low1;
+   high1 += (sum < high0);
+   return (high1 << (128 - shift)) | (sum >> (shift - 64));
 }
-#endif // CONFIG_KJSON_NO_FLOAT
 
-static bool BooleanFits(kjson_t *const jsonHandle, const char *const key, bool value)
+static void ShortestDouble(const uint64_t mantissa, const int exponent, DecimalFloat_t *const decimal)
 {
-   const size_t valueSize = strlen(value ? BOOLEAN_TRUE : BOOLEAN_FALSE);
-   const size_t size = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + valueSize + char_size(BOOLEAN) - char_size("%s") - char_size("%s");
-   return (jsonHandle->size + size <= jsonHandle->rootSize);
-}
+   // Ryu, as for floats but with 128 bit powers of 5. Those are rebuilt from
+   // every 26th power and a correction of up to 3, to keep the tables small
+   if (0 == mantissa)
+   {
+      decimal->digits[0] = '0';
+      decimal->count = 1;
+      decimal->exponent = 0;
+      return;
+   }
 
-static bool NullFits(kjson_t *const jsonHandle, const char *const key)
-{
-   const size_t valueSize = char_size(NULL_VALUE);
-   const size_t size = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + valueSize + char_size(BOOLEAN) - char_size("%s") - char_size("%s");
-   return (jsonHandle->size + size <= jsonHandle->rootSize);
-}
+   const int32_t e2 = exponent - 2;
+   const bool acceptBounds = (0 == (mantissa & 1));
 
-static bool ArrayNumberFits(kjson_t *const jsonHandle, const char *const key, const void *const array, const size_t size, const NumberType_e type)
-{
-   size_t total = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + char_size(ARRAY_KEY) - char_size("%s");
-   for (size_t i = 0; i < size; i++)
+   const uint64_t mv = 4 * mantissa;
+   const uint64_t mp = 4 * mantissa + 2;
+   const uint32_t mmShift = ((1ull << DOUBLE_MANTISSA_BITS) != mantissa) || (exponent <= 1 - DOUBLE_BIAS);
+   const uint64_t mm = 4 * mantissa - 1 - mmShift;
+
+   uint64_t factor[2];
+   uint64_t vr;
+   uint64_t vp;
+   uint64_t vm;
+   int32_t e10;
+   bool vmIsTrailingZeros = false;
+   bool vrIsTrailingZeros = false;
+   if (e2 >= 0)
    {
-      size_t valueSize = 0;
-      if (((int *)array)[i] == jsonHandle->nullIntValue)
+      // One less than log10(2^e2) above 2^3, so that the last removed digit is always computed below
+      const uint32_t q = (((uint32_t)e2 * 78913) >> 18) - (e2 > 3);
+      e10 = (int32_t)q;
+      const int32_t k = DOUBLE_POW5_INV_BITCOUNT + Pow5Bits((int32_t)q) - 1;
+      const int32_t i = -e2 + (int32_t)q + k;
+      ComputeInvPow5(q, factor);
+      vr = MulShift64(mv, factor, i);
+      vp = MulShift64(mp, factor, i);
+      vm = MulShift64(mm, factor, i);
+      if (q <= 21)
       {
-         valueSize = char_size(NULL_VALUE);
+         // Only one of mp, mv and mm can be a multiple of 5, if any
+         if (0 == mv % 5)
+         {
+            vrIsTrailingZeros = IsMultipleOfPow5(mv, q);
+         }
+         else if (acceptBounds)
+         {
+            vmIsTrailingZeros = IsMultipleOfPow5(mm, q);
+         }
+         else
+         {
+            vp -= IsMultipleOfPow5(mp, q);
+         }
       }
-      else if (eSigned == type)
+   }
+   else
+   {
+      // One less than log10(5^-e2) above 5^1
+      const uint32_t q = (((uint32_t)-e2 * 732923) >> 20) - (-e2 > 1);
+      e10 = (int32_t)q + e2;
+      const int32_t i = -e2 - (int32_t)q;
+      const int32_t k = Pow5Bits(i) - DOUBLE_POW5_BITCOUNT;
+      const int32_t j = (int32_t)q - k;
+      ComputePow5((uint32_t)i, factor);
+      vr = MulShift64(mv, factor, j);
+      vp = MulShift64(mp, factor, j);
+      vm = MulShift64(mm, factor, j);
+      if (q <= 1)
       {
-         const int num = *((int *)array + i);
-         valueSize = GetNumDigits(&num, type);
+         // mv = 4 * mantissa always has at least two trailing zero bits
+         vrIsTrailingZeros = true;
+         if (acceptBounds)
+         {
+            vmIsTrailingZeros = (1 == mmShift);
+         }
+         else
+         {
+            vp--;
+         }
       }
-      else
+      else if (q < 63)
       {
-         const unsigned int num = *((unsigned int *)array + i);
-         valueSize = GetNumDigits(&num, type);
+         vrIsTrailingZeros = 0 == (mv & ((1ull << q) - 1));
       }
-      total += valueSize + char_size(ARRAY_VALUE_NUMBER) - char_size("%d");
    }
-   total -= ARRAY_TRIM;
-   total += char_size(ARRAY_END);
-   return (jsonHandle->size + total <= jsonHandle->rootSize);
-}
 
-static bool ArrayFloatFits(kjson_t *const jsonHandle, const char *const key, const float *const array, const size_t size, const unsigned int decimals)
-{
-   size_t total = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + char_size(ARRAY_KEY) - char_size("%s");
-   for (size_t i = 0; i < size; i++)
+   int32_t removed = 0;
+   uint32_t lastRemovedDigit = 0;
+   uint64_t output;
+   if (vmIsTrailingZeros || vrIsTrailingZeros)
    {
-      if (IS_FLOAT_NULL(array[i], jsonHandle->nullFloatValue))
+      while (vp / 10 > vm / 10)
       {
-         total += char_size(NULL_VALUE) + char_size(ARRAY_VALUE_FLOAT) - char_size("%.*f");
+         vmIsTrailingZeros &= (0 == vm % 10);
+         vrIsTrailingZeros &= (0 == lastRemovedDigit);
+         lastRemovedDigit = (uint32_t)(vr % 10);
+         vr /= 10;
+         vp /= 10;
+         vm /= 10;
+         removed++;
       }
-      else
+      if (vmIsTrailingZeros)
+      {
+         while (0 == vm % 10)
+         {
+            vrIsTrailingZeros &= (0 == lastRemovedDigit);
+            lastRemovedDigit = (uint32_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+         }
+      }
+      if (vrIsTrailingZeros && (5 == lastRemovedDigit) && (0 == vr % 2))
+      {
+         // Exact halfway, round to even
+         lastRemovedDigit = 4;
+      }
+      output = vr + (((vr == vm) && (!acceptBounds || !vmIsTrailingZeros)) || (lastRemovedDigit >= 5));
+   }
+   else
+   {
+      while (vp / 10 > vm / 10)
       {
-         const int intVal = (int)array[i];
-         const size_t valueSize = GetNumDigits(&intVal, eSigned) + char_size(".") + decimals;
-         total += valueSize + char_size(ARRAY_VALUE_FLOAT) - char_size("%.*f");
+         lastRemovedDigit = (uint32_t)(vr % 10);
+         vr /= 10;
+         vp /= 10;
+         vm /= 10;
+         removed++;
       }
+      output = vr + ((vr == vm) || (lastRemovedDigit >= 5));
    }
-   total -= ARRAY_TRIM;
-   total += char_size(ARRAY_END);
-   return (jsonHandle->size + total <= jsonHandle->rootSize);
+   decimal->count = GetNumDigits64(output);
+   decimal->exponent = e10 + removed;
+   WriteUnsigned64(decimal->digits, output, decimal->count);
 }
 
-static bool ArrayStringFits(kjson_t *const jsonHandle, const char *const key, const char *const *const array, const size_t size)
+static size_t WriteShortest(char *const string, const DecimalFloat_t *const decimal)
 {
-   size_t total = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + char_size(ARRAY_KEY) - char_size("%s");
-   for (size_t i = 0; i < size; i++)
+   // Same layout as JavaScript's Number.prototype.toString()
+   char *const start = string;
+   char *end = start;
+   const char *const digits = decimal->digits;
+   const int count = (int)decimal->count;
+   const int point = count + decimal->exponent;
+   if ((count <= point) && (point <= SHORTEST_FIXED_MAX))
    {
-      if (array[i])
-      {
-         const size_t valueSize = strlen(array[i]);
-         total += valueSize + char_size(ARRAY_VALUE_STRING) - char_size("%s");
-      }
-      else
+      memcpy(end, digits, (size_t)count);
+      end += count;
+      memset(end, '0', (size_t)(point - count));
+      end += point - count;
+   }
+   else if ((0 < point) && (point <= SHORTEST_FIXED_MAX))
+   {
+      memcpy(end, digits, (size_t)point);
+      end += point;
+      *(end++) = '.';
+      memcpy(end, digits + point, (size_t)(count - point));
+      end += count - point;
+   }
+   else if ((SHORTEST_FIXED_MIN < point) && (point <= 0))
+   {
+      *(end++) = '0';
+      *(end++) = '.';
+      memset(end, '0', (size_t)-point);
+      end += -point;
+      memcpy(end, digits, (size_t)count);
+      end += count;
+   }
+   else
+   {
+      *(end++) = digits[0];
+      if (count > 1)
       {
-         total += char_size(ARRAY_VALUE_NULL);
+         *(end++) = '.';
+         memcpy(end, digits + 1, (size_t)(count - 1));
+         end += count - 1;
       }
+      *(end++) = 'e';
+      *(end++) = (point > 0) ? '+' : '-';
+      const uint32_t power = (uint32_t)((point > 0) ? (point - 1) : (1 - point));
+      end += WriteUnsigned(end, power, GetNumDigits(power));
+   }
+   return (size_t)(end - start);
+}
+
+static size_t GetShortestLength(const DecimalFloat_t *const decimal)
+{
+   const int count = (int)decimal->count;
+   const int point = count + decimal->exponent;
+   if ((count <= point) && (point <= SHORTEST_FIXED_MAX))
+   {
+      return (size_t)point;
+   }
+   if ((0 < point) && (point <= SHORTEST_FIXED_MAX))
+   {
+      return (size_t)count + char_size(".");
+   }
+   if ((SHORTEST_FIXED_MIN < point) && (point <= 0))
+   {
+      return char_size("0.") + (size_t)(count - point);
+   }
+   const uint32_t power = (uint32_t)((point > 0) ? (point - 1) : (1 - point));
+   return (size_t)count + ((count > 1) ? char_size(".") : 0) + char_size("e+") + GetNumDigits(power);
+}
+
+static size_t WriteFloat(char *const string, const DecimalFloat_t *const decimal)
+{
+   char *const start = string;
+   char *end = start;
+   if (decimal->negative)
+   {
+      *(end++) = '-';
+   }
+   if (decimal->shortest)
+   {
+      end += WriteShortest(end, decimal);
+   }
+   else if (decimal->exponent)
+   {
+      end += WriteLargeInteger(end, decimal->mantissa, decimal->exponent);
+   }
+   else
+   {
+      end += WriteUnsigned64(end, decimal->integer, GetNumDigits64(decimal->integer));
+   }
+   if (decimal->decimals)
+   {
+      *(end++) = '.';
+      end += WriteUnsigned(end, decimal->fraction, decimal->decimals);
    }
-   total -= ARRAY_TRIM;
-   total += char_size(ARRAY_END);
-   return (jsonHandle->size + total <= jsonHandle->rootSize);
+   return (size_t)(end - start);
+}
+
+static size_t GetFloatLength(const DecimalFloat_t *const decimal)
+{
+   size_t length = decimal->negative ? char_size("-") : 0;
+   if (decimal->shortest)
+   {
+      length += GetShortestLength(decimal);
+   }
+   else if (decimal->exponent)
+   {
+      length += WriteLargeInteger(NULL, decimal->mantissa, decimal->exponent);
+   }
+   else
+   {
+      length += GetNumDigits64(decimal->integer);
+   }
+   if (decimal->decimals)
+   {
+      length += char_size(".") + decimal->decimals;
+   }
+   return length;
+}
+
+static bool FloatFits(kjson_t *const jsonHandle, const kjson_key_t *const key, const size_t valueSize)
+{
+   const bool fits = Reserve(jsonHandle, GetEntryLength(jsonHandle, key, valueSize + char_size(",")));
+   STATS_FITS(jsonHandle);
+   return fits;
+}
+#endif // CONFIG_KJSON_NO_FLOAT
+
+static bool BooleanFits(kjson_t *const jsonHandle, const kjson_key_t *const key, bool value)
+{
+   const size_t valueSize = strlen(value ? BOOLEAN_TRUE : BOOLEAN_FALSE);
+   const bool fits = Reserve(jsonHandle, GetEntryLength(jsonHandle, key, valueSize + char_size(",")));
+   STATS_FITS(jsonHandle);
+   return fits;
+}
+
+static bool NullFits(kjson_t *const jsonHandle, const kjson_key_t *const key)
+{
+   const size_t valueSize = char_size(NULL_VALUE);
+   const bool fits = Reserve(jsonHandle, GetEntryLength(jsonHandle, key, valueSize + char_size(",")));
+   STATS_FITS(jsonHandle);
+   return fits;
 }
 
-static bool ObjectFits(kjson_t *const jsonHandle, const char *const key)
+static bool ObjectFits(kjson_t *const jsonHandle, const kjson_key_t *const key)
 {
    size_t size;
-   if (!key) size = strlen(jsonHandle->newLine) + jsonHandle->depth + char_size(OBJECT_KEYLESS) - char_size("%s");
-   else size = strlen(jsonHandle->newLine) + jsonHandle->depth + strlen(key) + char_size(OBJECT_KEY) - char_size("%s");
-   size += strlen(jsonHandle->newLine) + jsonHandle->depth + (char_size(OBJECT_END) - 1); // Closing bracket
-   return (jsonHandle->size + size <= jsonHandle->rootSize);
+   if (!key)
+   {
+      size = GetLineLength(jsonHandle) + char_size("{");
+   }
+   else
+   {
+      size = GetEntryLength(jsonHandle, key, char_size("{"));
+   }
+   size += GetLineLength(jsonHandle) + char_size(OBJECT_END); // Closing bracket
+   const bool fits = Reserve(jsonHandle, size);
+   STATS_FITS(jsonHandle);
+   return fits;
 }
 
+#if CONFIG_KJSON_HEADER_ONLY
+// Compiled into the file that included kJSON.h, which may have helpers of the same names
+#undef array_size
+#undef char_size
+#undef unused
+#endif
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -21,6 +21,7 @@ extern "C" {
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 //------------------------------------------------------------------------------
 // Module exported defines
@@ -38,6 +39,80 @@ extern "C" {
 #define CONFIG_KJSON_NO_FLOAT (0)
 #endif
 
+// Disables the SSE2/AVX2 string scanning, the scalar code is used instead
+#ifndef CONFIG_KJSON_NO_SIMD
+#define CONFIG_KJSON_NO_SIMD (0)
+#endif
+
+// Disables the structural check of raw values, they are copied without looking at them
+#ifndef CONFIG_KJSON_NO_RAW_CHECK
+#define CONFIG_KJSON_NO_RAW_CHECK (0)
+#endif
+
+// Counts inserts, output and truncations in kjson_t.stats, nothing is counted when disabled
+#ifndef CONFIG_KJSON_STATS
+#define CONFIG_KJSON_STATS (0)
+#endif
+
+// Also splits the cycles spent by the inserts between checking space and formatting (needs
+// CONFIG_KJSON_STATS). KJSON_CYCLES() reads the counter, __rdtsc is used on x86 when it is not defined
+#ifndef CONFIG_KJSON_STATS_CYCLES
+#define CONFIG_KJSON_STATS_CYCLES (0)
+#endif
+
+// Compiles kJSON.c into every file that includes kJSON.h, with static inline functions, so that
+// literal keys and constant sizes fold into the callers. kJSON.c is then not built on its own
+#ifndef CONFIG_KJSON_HEADER_ONLY
+#define CONFIG_KJSON_HEADER_ONLY (0)
+#endif
+
+#if CONFIG_KJSON_HEADER_ONLY
+#define KJSON_API static inline
+#else
+#define KJSON_API
+#endif
+
+// Size of the precomputed start of line in kjson_t (not with CONFIG_KJSON_SMALLEST), deeper lines are
+// indented with memset. Newline and 15 tabs by default
+#ifndef KJSON_LINE_SIZE
+#define KJSON_LINE_SIZE (16)
+#endif
+
+// Layouts for kjson_t.format, lines are ended with kjson_t.newLine
+#define KJSON_FORMAT_COMPACT {.pretty = false, .indent = '\0', .indentWidth = 0, .keySeparator = ""}
+#define KJSON_FORMAT_PRETTY {.pretty = true, .indent = '\t', .indentWidth = 1, .keySeparator = "\t"}
+
+// Prepared key for a string literal that needs no escaping (eg. KJSON_KEY("id")), for the ...WithKey
+// functions. Its length is a constant, the key is copied with a fixed size memcpy. C++ has no compound
+// literals, a static key is returned by a lambda instead (C++11)
+#ifdef __cplusplus
+#define KJSON_KEY(literal) ([]() -> const kjson_key_t * { static const kjson_key_t key = {"\"" literal "\":", sizeof("\"" literal "\":") - 1}; return &key; }())
+#else
+#define KJSON_KEY(literal) (&(const kjson_key_t){.text = "\"" literal "\":", .length = sizeof("\"" literal "\":") - 1})
+#endif
+
+// Maximum number of decimals printed for floating point values
+#define KJSON_MAX_DECIMALS (9)
+
+// Pass as decimals to print the shortest digits that read back to the same value
+#define KJSON_DECIMALS_SHORTEST (UINT_MAX)
+
+#define KJSON_GATHER_INITIALISE(buffer, bufferSize, minimum) \
+   {                                                        \
+      .references = (buffer),                               \
+      .referencesSize = (bufferSize),                       \
+      .threshold = (minimum),                               \
+      .count = 0                                            \
+   }
+
+#define KJSON_TEMPLATE_INITIALISE(buffer, bufferSize, slotBuffer, slotBufferSize) \
+   {                                                                              \
+      .json = KJSON_INITIALISE(buffer, bufferSize),                              \
+      .slots = (slotBuffer),                                                     \
+      .slotsSize = (slotBufferSize),                                             \
+      .count = 0                                                                 \
+   }
+
 #if CONFIG_KJSON_NO_FLOAT
 #define KJSON_INITIALISE(buffer, bufferSize) \
    {                                         \
@@ -47,9 +122,25 @@ extern "C" {
       .size = 0,                             \
       .depth = 0,                            \
       .newLine = "\n",                       \
+      .format = NULL,                        \
+      .ascii = KJSON_ASCII_OFF,              \
       .nullIntValue = (INT_MAX),             \
       .nullUIntValue = (UINT_MAX),           \
-      .truncated = false                     \
+      .nullInt64Value = (INT64_MAX),         \
+      .nullUInt64Value = (UINT64_MAX),       \
+      .nullInt8Value = (INT8_MAX),           \
+      .nullUInt8Value = (UINT8_MAX),         \
+      .nullInt16Value = (INT16_MAX),         \
+      .nullUInt16Value = (UINT16_MAX),       \
+      .nullInt32Value = (INT32_MAX),         \
+      .nullUInt32Value = (UINT32_MAX),       \
+      .write = NULL,                         \
+      .context = NULL,                       \
+      .gather = NULL,                        \
+      .batch = false,                        \
+      .records = 0,                          \
+      .truncated = false,                    \
+      .rejected = false                      \
    }
 #else
 #include <float.h>
@@ -61,42 +152,250 @@ extern "C" {
       .size = 0,                             \
       .depth = 0,                            \
       .newLine = "\n",                       \
+      .format = NULL,                        \
+      .ascii = KJSON_ASCII_OFF,              \
       .nullIntValue = (INT_MAX),             \
       .nullUIntValue = (UINT_MAX),           \
+      .nullInt64Value = (INT64_MAX),         \
+      .nullUInt64Value = (UINT64_MAX),       \
+      .nullInt8Value = (INT8_MAX),           \
+      .nullUInt8Value = (UINT8_MAX),         \
+      .nullInt16Value = (INT16_MAX),         \
+      .nullUInt16Value = (UINT16_MAX),       \
+      .nullInt32Value = (INT32_MAX),         \
+      .nullUInt32Value = (UINT32_MAX),       \
       .nullFloatValue = (FLT_MAX),           \
-      .truncated = false                     \
+      .nullDoubleValue = (DBL_MAX),          \
+      .write = NULL,                         \
+      .context = NULL,                       \
+      .gather = NULL,                        \
+      .batch = false,                        \
+      .records = 0,                          \
+      .truncated = false,                    \
+      .rejected = false                      \
    }
 #endif
 
 //------------------------------------------------------------------------------
 // Module exported type definitions
 //------------------------------------------------------------------------------
+typedef enum
+{
+   KJSON_ASCII_OFF = 0, // Strings are copied as they are, only JSON special characters are escaped
+   KJSON_ASCII_REPLACE, // Non-ASCII code points are written as \uXXXX, invalid UTF-8 as \ufffd
+   KJSON_ASCII_REJECT,  // Non-ASCII code points are written as \uXXXX, invalid UTF-8 is not inserted
+} kjson_ascii_e;
+
+typedef struct
+{
+   const char *value; // Referenced string
+   size_t length;     // Length of the string
+   size_t offset;     // Position of the string in the buffer
+} kjson_reference_t;
+
+typedef struct
+{
+   kjson_reference_t *const references; // Buffer to store the references
+   const size_t referencesSize;         // Number of references in the buffer
+   size_t threshold;                    // Strings of at least this length are referenced instead of copied
+   size_t count;                        // Number of references used
+} kjson_gather_t;
+
+typedef struct
+{
+   const void *base; // Start of the bytes
+   size_t length;    // Number of bytes
+} kjson_iovec_t;     // Same layout as the POSIX struct iovec
+
+/**
+ * @brief  Sink for the output of a JSON object
+ * @param  context: User context
+ * @param  data: Output so far
+ * @param  size: Size of the output
+ * @return True if the output was written
+ */
+typedef bool (*kjson_write_t)(void *const context, const char *const data, const size_t size);
+
+typedef struct
+{
+   bool pretty;               // Entries and closing brackets on their own lines, arrays of values separated by ", "
+   char indent;               // Character repeated at the start of a line for each level of depth
+   unsigned char indentWidth; // Number of indent characters per level of depth
+   const char *keySeparator;  // Written after the ':' of every key, NULL for none
+} kjson_format_t;
+
+typedef enum
+{
+   KJSON_STAT_STRING = 0, // Strings and arrays of strings
+   KJSON_STAT_NUMBER,     // Integers and arrays of integers
+   KJSON_STAT_FLOAT,      // Floats, doubles and their arrays
+   KJSON_STAT_BOOLEAN,    // Booleans
+   KJSON_STAT_NULL,       // Nulls, including the values inserted as null
+   KJSON_STAT_BINARY,     // Base64 and hex values and their arrays
+   KJSON_STAT_RAW,        // Raw values
+   KJSON_STAT_CONTAINER,  // Objects and arrays of objects
+   KJSON_STAT_SPLICE,     // Fragments
+   KJSON_STAT_COUNT,      // Number of types
+} kjson_stat_e;
+
+typedef struct
+{
+   size_t inserts[KJSON_STAT_COUNT]; // Inserts per type of value, whether they fit or not
+   size_t bytes;                     // Output of the finished objects (records kept, in batch mode)
+   size_t truncations;               // Entries that did not fit
+   size_t shortfall;                 // Bytes missing for the entries that did not fit, summed
+   size_t maxShortfall;              // Bytes missing for the largest entry that did not fit
+   size_t dropped;                   // Entries dropped inside objects and arrays that did not fit
+   size_t rejections;                // Entries rejected for invalid UTF-8 or raw JSON
+   size_t peakSize;                  // Largest size, with the reserved closing brackets, to compare with rootSize
+   size_t start;                     // Output before the object being written
+#if CONFIG_KJSON_STATS_CYCLES
+   uint64_t fitsCycles;   // Cycles spent sizing entries and checking that they fit
+   uint64_t formatCycles; // Cycles spent writing entries, speculative writers check space as they go
+   uint64_t mark;         // Counter at the end of the last phase measured
+#endif
+} kjson_stats_t;
+
+typedef struct
+{
+   const char *text; // Quoted and escaped key followed by ':', as it is inserted before the key separator
+   size_t length;    // Length of text
+} kjson_key_t;
+
 typedef struct
 {
    // Initialisation parameters
-   char *const root;      // Buffer to store output
-   const size_t rootSize; // Size of the buffer
-   char *tail;            // Point to last character inserted (point to root)
-   const char *newLine;   // Character to use for new line
+   char *const root;             // Buffer to store output, NULL to only measure it (measure mode)
+   const size_t rootSize;        // Size of the buffer
+   char *tail;                   // Point to last character inserted (point to root)
+   const char *newLine;          // Character to use for new line
+   const kjson_format_t *format; // Layout of the output, NULL for KJSON_FORMAT_PRETTY (compact with CONFIG_KJSON_SMALLEST)
+   kjson_ascii_e ascii;          // 7-bit output mode for keys and strings
+   bool batch;                   // Records are appended one per line (NDJSON), a sink is handed whole records only
+   kjson_write_t write;          // Optional sink, the buffer is flushed to it when full instead of truncating
+   void *context;                // Passed to write
+   kjson_gather_t *gather;       // Optional gather list, long strings are referenced instead of copied (not with a sink)
 
    int nullIntValue;           // Value that marks a null integer
    unsigned int nullUIntValue; // Value that marks a null unsigned integer
+   int64_t nullInt64Value;     // Value that marks a null 64-bit integer
+   uint64_t nullUInt64Value;   // Value that marks a null 64-bit unsigned integer
+   int8_t nullInt8Value;       // Value that marks a null 8-bit integer
+   uint8_t nullUInt8Value;     // Value that marks a null 8-bit unsigned integer
+   int16_t nullInt16Value;     // Value that marks a null 16-bit integer
+   uint16_t nullUInt16Value;   // Value that marks a null 16-bit unsigned integer
+   int32_t nullInt32Value;     // Value that marks a null 32-bit integer
+   uint32_t nullUInt32Value;   // Value that marks a null 32-bit unsigned integer
 #if !CONFIG_KJSON_NO_FLOAT
-   float nullFloatValue; // Value that marks a null float
+   float nullFloatValue;   // Value that marks a null float
+   double nullDoubleValue; // Value that marks a null double
 #endif
 
    // Output parameters
-   size_t size;    // Size of the output
-   bool truncated; // True if some objects could not fit
+   size_t size;    // Size of the output (in the buffer, since the last flush, when using a sink, the whole output in measure mode)
+   size_t records; // Number of records in the buffer (batch mode)
+   bool truncated; // True if some objects could not fit (in batch mode, some records were rolled back)
+   bool rejected;  // True if some objects were not inserted for invalid UTF-8 or raw JSON (also sets truncated)
+#if CONFIG_KJSON_STATS
+   kjson_stats_t stats; // Counters, kept across kJSON_Reset, set to zero to start over
+#endif
 
-   // Internal parameters
-   unsigned short depth; // Used to track the depth of the JSON object
+   // Internal parameters, the small fields first so that they share a word
+   unsigned short depth;   // Used to track the depth of the JSON object
+   unsigned short skipped; // Objects and arrays that did not fit, their entries and closing are dropped
+   bool batchTruncated;    // Truncated state of the batch before the record being written
+   char last;              // Last character of the output, tracked instead of read back (measure mode)
+#if !CONFIG_KJSON_SMALLEST
+   unsigned char indentWidth;          // Indent characters per level of depth
+   unsigned char arraySeparatorLength; // Length of the separator between the values of arrays
+   char indent;                        // Indent character
+#endif
+   size_t record;   // Start of the record being written (batch mode)
+   size_t flushed;  // Bytes handed to the sink
+   size_t restored; // Lowest offset restored by kJSON_Rollback since the last template slot, plus one (0 if none)
+#if !CONFIG_KJSON_SMALLEST
+   const char *keySeparator;    // Resolved format->keySeparator
+   size_t lineLength;           // Length of the newline, 0 for compact output
+   size_t keySeparatorLength;   // Length of keySeparator
+   char lines[KJSON_LINE_SIZE]; // Newline followed by indentation, the start of each line is copied from it
+#endif
 } kjson_t;
 
+typedef struct
+{
+   size_t offset;          // Position of the tail in the buffer
+   size_t size;            // Size of the output, with the reserved closing brackets
+   size_t flushed;         // Bytes handed to the sink, the output before them cannot be restored
+   size_t records;         // Number of records in the buffer (batch mode)
+   size_t record;          // Start of the record being written (batch mode)
+   size_t references;      // Number of references in the gather list
+   unsigned short depth;   // Depth of the JSON object
+   unsigned short skipped; // Objects and arrays being dropped
+   bool truncated;         // Truncated state
+   bool rejected;          // Rejected state
+   bool batchTruncated;    // Truncated state of the batch
+   char last;              // Character before the tail, overwritten when a comma is trimmed
+} kjson_checkpoint_t;
+
+typedef enum
+{
+   KJSON_SLOT_NUMBER = 0,
+   KJSON_SLOT_UNSIGNED_NUMBER,
+   KJSON_SLOT_NUMBER64,
+   KJSON_SLOT_UNSIGNED_NUMBER64,
+#if !CONFIG_KJSON_NO_FLOAT
+   KJSON_SLOT_FLOAT,
+   KJSON_SLOT_DOUBLE,
+#endif
+   KJSON_SLOT_BOOLEAN,
+   KJSON_SLOT_STRING,
+} kjson_slot_e;
+
+typedef union
+{
+   int number;
+   unsigned int unsignedNumber;
+   int64_t number64;
+   uint64_t unsignedNumber64;
+#if !CONFIG_KJSON_NO_FLOAT
+   float floatNumber;
+   double doubleNumber;
+#endif
+   bool boolean;
+   const char *string; // NULL is inserted as null
+} kjson_value_t;
+
+typedef struct
+{
+   size_t offset;         // Position of the value in the template text
+   kjson_slot_e type;     // Type of the value
+   unsigned int decimals; // Decimals of float and double values
+} kjson_slot_t;
+
+typedef struct
+{
+   kjson_t json;              // Records the template text, used with the other kJSON functions
+   kjson_slot_t *const slots; // Buffer to store the value slots
+   const size_t slotsSize;    // Number of slots in the buffer
+   size_t count;              // Number of slots recorded
+} kjson_template_t;
+
 //------------------------------------------------------------------------------
 // Module exported functions
 //------------------------------------------------------------------------------
 
+/**
+ * @brief  Prepares a key once, so that inserting it is a single copy
+ * @note   The key is escaped for the given 7-bit mode, the key separator of the format is added when it is inserted
+ * @param  keyHandle: Key to prepare
+ * @param  buffer: Storage for the prepared key, must outlive it
+ * @param  bufferSize: Size of the buffer
+ * @param  key: Key to prepare
+ * @param  ascii: 7-bit output mode of the JSON objects the key is inserted into
+ * @return True if the key was prepared, false if it does not fit or is rejected as invalid UTF-8
+ */
+KJSON_API bool kJSON_PrepareKey(kjson_key_t *const keyHandle, char *const buffer, const size_t bufferSize, const char *const key, const kjson_ascii_e ascii);
+
 /**
  * @brief  Inserts a string into the JSON object
  * @param  jsonHandle: JSON object handle
@@ -104,7 +403,16 @@ typedef struct
  * @param  value: Value of the string
  * @return None
  */
-void kJSON_InsertString(kjson_t *const jsonHandle, const char *const key, const char *const value);
+KJSON_API void kJSON_InsertString(kjson_t *const jsonHandle, const char *const key, const char *const value);
+
+/**
+ * @brief  Inserts a string into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the string, prepared with kJSON_PrepareKey
+ * @param  value: Value of the string
+ * @return None
+ */
+KJSON_API void kJSON_InsertStringWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const value);
 
 /**
  * @brief  Inserts a number into the JSON object
@@ -113,7 +421,16 @@ void kJSON_InsertString(kjson_t *const jsonHandle, const char *const key, const
  * @param  value: Value of the number
  * @return None
  */
-void kJSON_InsertNumber(kjson_t *const jsonHandle, const char *const key, const int value);
+KJSON_API void kJSON_InsertNumber(kjson_t *const jsonHandle, const char *const key, const int value);
+
+/**
+ * @brief  Inserts a number into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the number, prepared with kJSON_PrepareKey
+ * @param  value: Value of the number
+ * @return None
+ */
+KJSON_API void kJSON_InsertNumberWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int value);
 
 /**
  * @brief  Inserts an unsigned number into the JSON object
@@ -122,17 +439,98 @@ void kJSON_InsertNumber(kjson_t *const jsonHandle, const char *const key, const
  * @param  value: Value of the number
  * @return None
  */
-void kJSON_InsertUnsignedNumber(kjson_t *const jsonHandle, const char *const key, const unsigned int value);
+KJSON_API void kJSON_InsertUnsignedNumber(kjson_t *const jsonHandle, const char *const key, const unsigned int value);
+
+/**
+ * @brief  Inserts an unsigned number into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the number, prepared with kJSON_PrepareKey
+ * @param  value: Value of the number
+ * @return None
+ */
+KJSON_API void kJSON_InsertUnsignedNumberWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const unsigned int value);
+
+/**
+ * @brief  Inserts a 64-bit number into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the number
+ * @param  value: Value of the number
+ * @return None
+ */
+KJSON_API void kJSON_InsertNumber64(kjson_t *const jsonHandle, const char *const key, const int64_t value);
+
+/**
+ * @brief  Inserts a 64-bit number into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the number, prepared with kJSON_PrepareKey
+ * @param  value: Value of the number
+ * @return None
+ */
+KJSON_API void kJSON_InsertNumber64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int64_t value);
 
+/**
+ * @brief  Inserts a 64-bit unsigned number into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the number
+ * @param  value: Value of the number
+ * @return None
+ */
+KJSON_API void kJSON_InsertUnsignedNumber64(kjson_t *const jsonHandle, const char *const key, const uint64_t value);
+
+/**
+ * @brief  Inserts a 64-bit unsigned number into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the number, prepared with kJSON_PrepareKey
+ * @param  value: Value of the number
+ * @return None
+ */
+KJSON_API void kJSON_InsertUnsignedNumber64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint64_t value);
+
+#if !CONFIG_KJSON_NO_FLOAT
 /**
  * @brief  Inserts a float into the JSON object
+ * @note   The output does not depend on the locale, infinities and NaNs are inserted as null
  * @param  jsonHandle: JSON object handle
  * @param  key: Key of the float
  * @param  value: Value of the float
- * @param  decimals: Number of decimals to use
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
+ * @return None
+ */
+KJSON_API void kJSON_InsertFloat(kjson_t *const jsonHandle, const char *const key, const float value, const unsigned int decimals);
+
+/**
+ * @brief  Inserts a float into the JSON object
+ * @note   The output does not depend on the locale, infinities and NaNs are inserted as null
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the float, prepared with kJSON_PrepareKey
+ * @param  value: Value of the float
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
+ * @return None
+ */
+KJSON_API void kJSON_InsertFloatWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const float value, const unsigned int decimals);
+
+/**
+ * @brief  Inserts a double into the JSON object
+ * @note   The output does not depend on the locale, infinities and NaNs are inserted as null
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the double
+ * @param  value: Value of the double
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
+ * @return None
+ */
+KJSON_API void kJSON_InsertDouble(kjson_t *const jsonHandle, const char *const key, const double value, const unsigned int decimals);
+
+/**
+ * @brief  Inserts a double into the JSON object
+ * @note   The output does not depend on the locale, infinities and NaNs are inserted as null
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the double, prepared with kJSON_PrepareKey
+ * @param  value: Value of the double
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
  * @return None
  */
-void kJSON_InsertFloat(kjson_t *const jsonHandle, const char *const key, const float value, const unsigned int decimals);
+KJSON_API void kJSON_InsertDoubleWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const double value, const unsigned int decimals);
+#endif
 
 /**
  * @brief  Inserts a boolean into the JSON object
@@ -141,7 +539,16 @@ void kJSON_InsertFloat(kjson_t *const jsonHandle, const char *const key, const f
  * @param  value: Value of the boolean
  * @return None
  */
-void kJSON_InsertBoolean(kjson_t *const jsonHandle, const char *const key, const bool value);
+KJSON_API void kJSON_InsertBoolean(kjson_t *const jsonHandle, const char *const key, const bool value);
+
+/**
+ * @brief  Inserts a boolean into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the boolean, prepared with kJSON_PrepareKey
+ * @param  value: Value of the boolean
+ * @return None
+ */
+KJSON_API void kJSON_InsertBooleanWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const bool value);
 
 /**
  * @brief  Inserts a null into the JSON object
@@ -149,38 +556,261 @@ void kJSON_InsertBoolean(kjson_t *const jsonHandle, const char *const key, const
  * @param  key: Key of the null
  * @return None
  */
-void kJSON_InsertNull(kjson_t *const jsonHandle, const char *const key);
+KJSON_API void kJSON_InsertNull(kjson_t *const jsonHandle, const char *const key);
+
+/**
+ * @brief  Inserts a null into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the null, prepared with kJSON_PrepareKey
+ * @return None
+ */
+KJSON_API void kJSON_InsertNullWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key);
+
+/**
+ * @brief  Inserts an array of numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt(kjson_t *const jsonHandle, const char *const key, const int *const array, const size_t size);
 
 /**
  * @brief  Inserts an array of numbers into the JSON object
  * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayIntWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
  * @param  key: Key of the array
  * @param  array: Array of numbers
  * @param  size: Size of the array
  * @return None
  */
-void kJSON_InsertArrayInt(kjson_t *const jsonHandle, const char *const key, const int *const array, const size_t size);
+KJSON_API void kJSON_InsertArrayUInt(kjson_t *const jsonHandle, const char *const key, const unsigned int *const array, const size_t size);
 
 /**
  * @brief  Inserts an array of unsigned numbers into the JSON object
  * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUIntWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const unsigned int *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 64-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt64(kjson_t *const jsonHandle, const char *const key, const int64_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 64-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int64_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 64-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
  * @param  key: Key of the array
  * @param  array: Array of numbers
  * @param  size: Size of the array
  * @return None
  */
-void kJSON_InsertArrayUInt(kjson_t *const jsonHandle, const char *const key, const unsigned int *const array, const size_t size);
+KJSON_API void kJSON_InsertArrayUInt64(kjson_t *const jsonHandle, const char *const key, const uint64_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 64-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint64_t *const array, const size_t size);
 
+/**
+ * @brief  Inserts an array of 8-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt8(kjson_t *const jsonHandle, const char *const key, const int8_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 8-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt8WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int8_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 8-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt8(kjson_t *const jsonHandle, const char *const key, const uint8_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 8-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt8WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint8_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 16-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt16(kjson_t *const jsonHandle, const char *const key, const int16_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 16-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt16WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int16_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 16-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt16(kjson_t *const jsonHandle, const char *const key, const uint16_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 16-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt16WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint16_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 32-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt32(kjson_t *const jsonHandle, const char *const key, const int32_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 32-bit numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayInt32WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const int32_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 32-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt32(kjson_t *const jsonHandle, const char *const key, const uint32_t *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of 32-bit unsigned numbers into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of numbers
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayUInt32WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const uint32_t *const array, const size_t size);
+
+#if !CONFIG_KJSON_NO_FLOAT
 /**
  * @brief  Inserts an array of floats into the JSON object
  * @param  jsonHandle: JSON object handle
  * @param  key: Key of the array
  * @param  array: Array of floats
  * @param  size: Size of the array
- * @param  decimals: Number of decimals to use
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayFloat(kjson_t *const jsonHandle, const char *const key, const float *const array, const size_t size, const unsigned int decimals);
+
+/**
+ * @brief  Inserts an array of floats into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of floats
+ * @param  size: Size of the array
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayFloatWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const float *const array, const size_t size, const unsigned int decimals);
+
+/**
+ * @brief  Inserts an array of doubles into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of doubles
+ * @param  size: Size of the array
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
  * @return None
  */
-void kJSON_InsertArrayFloat(kjson_t *const jsonHandle, const char *const key, const float *const array, const size_t size, const unsigned int decimals);
+KJSON_API void kJSON_InsertArrayDouble(kjson_t *const jsonHandle, const char *const key, const double *const array, const size_t size, const unsigned int decimals);
+
+/**
+ * @brief  Inserts an array of doubles into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of doubles
+ * @param  size: Size of the array
+ * @param  decimals: Number of decimals to use, up to KJSON_MAX_DECIMALS, or KJSON_DECIMALS_SHORTEST
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayDoubleWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const double *const array, const size_t size, const unsigned int decimals);
+#endif
 
 /**
  * @brief  Inserts an array of strings into the JSON object
@@ -190,21 +820,171 @@ void kJSON_InsertArrayFloat(kjson_t *const jsonHandle, const char *const key, co
  * @param  size: Size of the array
  * @return None
  */
-void kJSON_InsertArrayString(kjson_t *const jsonHandle, const char *const key, const char *const *const array, const size_t size);
+KJSON_API void kJSON_InsertArrayString(kjson_t *const jsonHandle, const char *const key, const char *const *const array, const size_t size);
+
+/**
+ * @brief  Inserts an array of strings into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of strings
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayStringWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const *const array, const size_t size);
+
+/**
+ * @brief  Inserts binary data into the JSON object as a base64 string
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the data
+ * @param  data: Data to encode, NULL is inserted as null
+ * @param  length: Length of the data in bytes
+ * @return None
+ */
+KJSON_API void kJSON_InsertBase64(kjson_t *const jsonHandle, const char *const key, const void *const data, const size_t length);
+
+/**
+ * @brief  Inserts binary data into the JSON object as a base64 string
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the data, prepared with kJSON_PrepareKey
+ * @param  data: Data to encode, NULL is inserted as null
+ * @param  length: Length of the data in bytes
+ * @return None
+ */
+KJSON_API void kJSON_InsertBase64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const data, const size_t length);
+
+/**
+ * @brief  Inserts an array of binary data into the JSON object as base64 strings
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of data, NULL entries are inserted as null
+ * @param  lengths: Length of each entry in bytes
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayBase64(kjson_t *const jsonHandle, const char *const key, const void *const *const array, const size_t *const lengths, const size_t size);
+
+/**
+ * @brief  Inserts an array of binary data into the JSON object as base64 strings
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of data, NULL entries are inserted as null
+ * @param  lengths: Length of each entry in bytes
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayBase64WithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size);
+
+/**
+ * @brief  Inserts binary data into the JSON object as a lowercase hex string
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the data
+ * @param  data: Data to encode, NULL is inserted as null
+ * @param  length: Length of the data in bytes
+ * @return None
+ */
+KJSON_API void kJSON_InsertHex(kjson_t *const jsonHandle, const char *const key, const void *const data, const size_t length);
+
+/**
+ * @brief  Inserts binary data into the JSON object as a lowercase hex string
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the data, prepared with kJSON_PrepareKey
+ * @param  data: Data to encode, NULL is inserted as null
+ * @param  length: Length of the data in bytes
+ * @return None
+ */
+KJSON_API void kJSON_InsertHexWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const data, const size_t length);
+
+/**
+ * @brief  Inserts an array of binary data into the JSON object as lowercase hex strings
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array
+ * @param  array: Array of data, NULL entries are inserted as null
+ * @param  lengths: Length of each entry in bytes
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayHex(kjson_t *const jsonHandle, const char *const key, const void *const *const array, const size_t *const lengths, const size_t size);
+
+/**
+ * @brief  Inserts an array of binary data into the JSON object as lowercase hex strings
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @param  array: Array of data, NULL entries are inserted as null
+ * @param  lengths: Length of each entry in bytes
+ * @param  size: Size of the array
+ * @return None
+ */
+KJSON_API void kJSON_InsertArrayHexWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const void *const *const array, const size_t *const lengths, const size_t size);
+
+/**
+ * @brief  Inserts a value that is already serialised, eg. a cached object or array
+ * @note   The value is copied as it is, it is not re-indented. Unless CONFIG_KJSON_NO_RAW_CHECK
+ *         is set, a value that is not a single value with closed strings and matched brackets
+ *         (or that is not 7-bit in ascii mode) is not inserted and sets rejected
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the value
+ * @param  json: Serialised value, NULL is inserted as null
+ * @param  length: Length of the value
+ * @return None
+ */
+KJSON_API void kJSON_InsertRaw(kjson_t *const jsonHandle, const char *const key, const char *const json, const size_t length);
+
+/**
+ * @brief  Inserts a value that is already serialised, eg. a cached object or array
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the value, prepared with kJSON_PrepareKey
+ * @param  json: Serialised value, NULL is inserted as null
+ * @param  length: Length of the value
+ * @return None
+ */
+KJSON_API void kJSON_InsertRawWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key, const char *const json, const size_t length);
 
 /**
  * @brief  Inserts the root object into the JSON object
+ * @note   The buffer must at least fit the empty object and its terminator. In batch mode the
+ *         object is appended to the records already in the buffer. In measure mode (NULL buffer)
+ *         nothing is written, size counts the output as it would be written with an unlimited
+ *         buffer, without the terminator. The sink, gather list and templates are not used.
+ *         The format and newline are read here, they apply until the next call
  * @param  jsonHandle: JSON object handle
  * @return None
  */
-void kJSON_InitRoot(kjson_t *const jsonHandle);
+KJSON_API void kJSON_InitRoot(kjson_t *const jsonHandle);
 
 /**
  * @brief  Terminates the root object
+ * @note   When using a sink, the rest of the output is flushed to it. In batch mode the record is
+ *         ended with a new line and kept only if it fits whole, the sink is left for kJSON_Reset
+ * @param  jsonHandle: JSON object handle
+ * @return None
+ */
+KJSON_API void kJSON_ExitRoot(kjson_t *const jsonHandle);
+
+/**
+ * @brief  Empties the buffer to write a new object, or a new batch of records
+ * @note   In batch mode with a sink, the records in the buffer are flushed to it first
+ * @param  jsonHandle: JSON object handle
+ * @return False if the records could not be flushed to the sink, they are dropped anyway
+ */
+KJSON_API bool kJSON_Reset(kjson_t *const jsonHandle);
+
+/**
+ * @brief  Saves the state of the JSON object, to drop what is inserted after it with kJSON_Rollback
  * @param  jsonHandle: JSON object handle
+ * @param  checkpoint: Checkpoint to store the state
  * @return None
  */
-void kJSON_ExitRoot(kjson_t *const jsonHandle);
+KJSON_API void kJSON_Checkpoint(const kjson_t *const jsonHandle, kjson_checkpoint_t *const checkpoint);
+
+/**
+ * @brief  Restores the state of the JSON object saved by kJSON_Checkpoint, including the truncated flag
+ * @note   Objects and arrays entered since the checkpoint do not need to be exited, template slots
+ *         recorded since the checkpoint are dropped
+ * @param  jsonHandle: JSON object handle
+ * @param  checkpoint: Checkpoint taken on the same JSON object
+ * @return False if output since the checkpoint was already flushed to the sink, the state is left as it is
+ */
+KJSON_API bool kJSON_Rollback(kjson_t *const jsonHandle, const kjson_checkpoint_t *const checkpoint);
 
 /**
  * @brief  Inserts an object into the JSON object
@@ -212,14 +992,22 @@ void kJSON_ExitRoot(kjson_t *const jsonHandle);
  * @param  key: Key of the object
  * @return None
  */
-void kJSON_EnterObject(kjson_t *const jsonHandle, const char *const key);
+KJSON_API void kJSON_EnterObject(kjson_t *const jsonHandle, const char *const key);
+
+/**
+ * @brief  Inserts an object into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the object, prepared with kJSON_PrepareKey, or NULL inside an array
+ * @return None
+ */
+KJSON_API void kJSON_EnterObjectWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key);
 
 /**
  * @brief  Terminates the object
  * @param  jsonHandle: JSON object handle
  * @return None
  */
-void kJSON_ExitObject(kjson_t *const jsonHandle);
+KJSON_API void kJSON_ExitObject(kjson_t *const jsonHandle);
 
 /**
  * @brief  Inserts an array of objects into the JSON object
@@ -227,14 +1015,112 @@ void kJSON_ExitObject(kjson_t *const jsonHandle);
  * @param  key: Key of the array
  * @return None
  */
-void kJSON_EnterArray(kjson_t *const jsonHandle, const char *const key);
+KJSON_API void kJSON_EnterArray(kjson_t *const jsonHandle, const char *const key);
+
+/**
+ * @brief  Inserts an array of objects into the JSON object
+ * @param  jsonHandle: JSON object handle
+ * @param  key: Key of the array, prepared with kJSON_PrepareKey
+ * @return None
+ */
+KJSON_API void kJSON_EnterArrayWithKey(kjson_t *const jsonHandle, const kjson_key_t *const key);
 
 /**
  * @brief  Terminates the array of objects
  * @param  jsonHandle: JSON object handle
  * @return None
  */
-void kJSON_ExitArray(kjson_t *const jsonHandle);
+KJSON_API void kJSON_ExitArray(kjson_t *const jsonHandle);
+
+/**
+ * @brief  Starts a fragment, the body of an object or array built on its own buffer
+ * @note   The entries are written at depth 0 without brackets, and kJSON_Splice copies them
+ *         into a parent. Fragments share no state, each can be built on a different thread.
+ *         The buffer needs no room for a terminator, sinks and gather lists are not supported.
+ *         The fragment must use the format of the parent it is spliced into
+ * @param  jsonHandle: Fragment handle
+ * @return None
+ */
+KJSON_API void kJSON_InitFragment(kjson_t *const jsonHandle);
+
+/**
+ * @brief  Copies a finished fragment into the JSON object at the current position
+ * @note   Every line of the fragment is indented to the current depth. A fragment that is
+ *         not finished, or does not fit, is not copied and sets truncated
+ * @param  jsonHandle: JSON object handle
+ * @param  fragment: Fragment handle, started with kJSON_InitFragment
+ * @return None
+ */
+KJSON_API void kJSON_Splice(kjson_t *const jsonHandle, const kjson_t *const fragment);
+
+/**
+ * @brief  Records a value slot into a template, filled in by kJSON_RenderTemplate
+ * @param  templateHandle: Template handle
+ * @param  key: Key of the value
+ * @param  type: Type of the value, an unknown type truncates the template
+ * @param  decimals: Number of decimals for float and double values, ignored for other types
+ * @return None
+ */
+KJSON_API void kJSON_InsertSlot(kjson_template_t *const templateHandle, const char *const key, const kjson_slot_e type, const unsigned int decimals);
+
+/**
+ * @brief  Records a value slot into a template, filled in by kJSON_RenderTemplate
+ * @param  templateHandle: Template handle
+ * @param  key: Key of the value, prepared with kJSON_PrepareKey
+ * @param  type: Type of the value, an unknown type truncates the template
+ * @param  decimals: Number of decimals for float and double values, ignored for other types
+ * @return None
+ */
+KJSON_API void kJSON_InsertSlotWithKey(kjson_template_t *const templateHandle, const kjson_key_t *const key, const kjson_slot_e type, const unsigned int decimals);
+
+/**
+ * @brief  Writes a recorded template with a new set of values
+ * @note   The null values and 7-bit mode of the template JSON object apply to the values.
+ *         Gather lists are not supported, a template with referenced strings is not rendered
+ * @param  templateHandle: Template handle, recorded up to kJSON_ExitRoot
+ * @param  values: One value per slot, in the order the slots were recorded
+ * @param  buffer: Buffer to store output
+ * @param  bufferSize: Size of the buffer
+ * @return Size of the output, 0 if it does not fit, the template is not finished, is truncated, references strings or a string is rejected
+ */
+KJSON_API size_t kJSON_RenderTemplate(const kjson_template_t *const templateHandle, const kjson_value_t *const values, char *const buffer, const size_t bufferSize);
+
+/**
+ * @brief  Lists the output of a JSON object using a gather list, for writev() or sendmsg()
+ * @note   Referenced strings are used in place and must stay valid until the output is sent
+ * @param  jsonHandle: JSON object handle, terminated with kJSON_ExitRoot
+ * @param  iov: Buffer to store the output list, at least twice the number of references plus one
+ * @param  iovSize: Number of entries in the buffer
+ * @param  size: Total size of the output, including the referenced strings (can be NULL)
+ * @return Number of entries used, 0 if the buffer is too small or in measure mode
+ */
+KJSON_API size_t kJSON_Gather(const kjson_t *const jsonHandle, kjson_iovec_t *const iov, const size_t iovSize, size_t *const size);
+
+/**
+ * @brief  Reformats compact JSON into the layout of KJSON_FORMAT_PRETTY
+ * @note   Arrays of values stay on one line, as kJSON_InsertArray... writes them. Documents
+ *         can be composed with the compact build and only the ones that are read pretty printed.
+ *         The input and output cannot overlap
+ * @param  buffer: Buffer to store the output, NULL to only measure it
+ * @param  bufferSize: Size of the buffer
+ * @param  json: JSON to reformat, eg. NDJSON records, whitespace between documents is kept
+ * @param  length: Length of the JSON
+ * @param  newLine: Newline to use, NULL for "\n"
+ * @return Size of the output, 0 and an empty buffer if it does not fit (the size needed when measuring)
+ */
+KJSON_API size_t kJSON_Prettify(char *const buffer, const size_t bufferSize, const char *const json, const size_t length, const char *const newLine);
+
+/**
+ * @brief  Reformats JSON into the layout of KJSON_FORMAT_COMPACT
+ * @note   Whitespace is removed, except between documents. The output is never longer
+ *         than the input, it can be written in place (buffer equal to json)
+ * @param  buffer: Buffer to store the output, NULL to only measure it
+ * @param  bufferSize: Size of the buffer
+ * @param  json: JSON to reformat
+ * @param  length: Length of the JSON
+ * @return Size of the output, 0 and an empty buffer if it does not fit (the size needed when measuring)
+ */
+KJSON_API size_t kJSON_Minify(char *const buffer, const size_t bufferSize, const char *const json, const size_t length);
 
 //------------------------------------------------------------------------------
 // Module exported variables
@@ -247,3 +1133,9 @@ void kJSON_ExitArray(kjson_t *const jsonHandle);
 #ifdef __cplusplus
 }
 #endif
+
+#if CONFIG_KJSON_HEADER_ONLY
+#pragma GCC diagnostic push
+#include "kJSON.c"
+#pragma GCC diagnostic pop
+#endif
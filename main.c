@@ -73,8 +73,7 @@ int main(void)
    }
 
    // Reset the json object
-   json.tail = json.root;
-   json.size = 0;
+   kJSON_Reset(jsonHandle);
 
    return 0;
 }
@@ -13,6 +13,14 @@
 
 #define array_size(array) (sizeof(array) / sizeof(array[0]))
 
+typedef struct
+{
+   char *root;     // Output collected from the sink
+   size_t size;    // Size of the output
+   size_t space;   // Space left in the output
+   bool truncated; // Copied from the JSON object
+} sink_t;
+
 #define TEST(test) \
    if (!test)      \
    {               \
@@ -53,25 +61,431 @@ static bool kJSON_InsertNumber_PASS(void);
 static bool kJSON_InsertNumber_FAIL(void);
 static bool kJSON_InsertUnsignedNumber_PASS(void);
 static bool kJSON_InsertUnsignedNumber_FAIL(void);
+#if !CONFIG_KJSON_NO_FLOAT
 static bool kJSON_InsertFloat_PASS(void);
 static bool kJSON_InsertFloat_FAIL(void);
+#endif
 static bool kJSON_InsertString_PASS(void);
 static bool kJSON_InsertString_FAIL(void);
+static bool kJSON_InsertStringEscaped_PASS(void);
+static bool kJSON_InsertStringEscaped_FAIL(void);
+static bool kJSON_InsertStringAscii_PASS(void);
+static bool kJSON_InsertStringAscii_FAIL(void);
+static bool kJSON_InsertStringReject_PASS(void);
 static bool kJSON_InsertNull_PASS(void);
 static bool kJSON_InsertNull_FAIL(void);
+#if !CONFIG_KJSON_NO_FLOAT
 static bool kJSON_InsertNullFloat_PASS(void);
+#endif
 static bool kJSON_InsertBoolean_PASS(void);
 static bool kJSON_InsertBoolean_FAIL(void);
 static bool kJSON_InsertArrayInt_PASS(void);
 static bool kJSON_InsertArrayInt_FAIL(void);
+static bool kJSON_InsertArrayUInt_PASS(void);
+static bool kJSON_InsertArrayUInt_FAIL(void);
+static bool kJSON_InsertArrayInt64_PASS(void);
+static bool kJSON_InsertArrayInt64_FAIL(void);
+static bool kJSON_InsertArrayUInt64_PASS(void);
+static bool kJSON_InsertArrayUInt64_FAIL(void);
+static bool kJSON_InsertArrayDigits_PASS(void);
+static bool kJSON_InsertArrayDigits_FAIL(void);
+static bool kJSON_InsertArrayFixedWidth_PASS(void);
+static bool kJSON_InsertArrayFixedWidth_FAIL(void);
+#if !CONFIG_KJSON_NO_FLOAT
 static bool kJSON_InsertArrayFloat_PASS(void);
 static bool kJSON_InsertArrayFloat_FAIL(void);
+static bool kJSON_InsertArrayFloatLimits_PASS(void);
+static bool kJSON_InsertArrayFloatLimits_FAIL(void);
+static bool kJSON_InsertArrayFloatShortest_PASS(void);
+static bool kJSON_InsertArrayFloatShortest_FAIL(void);
+static bool kJSON_InsertArrayDoubleLimits_PASS(void);
+static bool kJSON_InsertArrayDoubleLimits_FAIL(void);
+static bool kJSON_InsertArrayDoubleShortest_PASS(void);
+static bool kJSON_InsertArrayDoubleShortest_FAIL(void);
+#endif
 static bool kJSON_InsertArrayString_PASS(void);
 static bool kJSON_InsertArrayString_FAIL(void);
+static bool kJSON_InsertBase64_PASS(void);
+static bool kJSON_InsertBase64_FAIL(void);
+static bool kJSON_InsertHex_PASS(void);
+static bool kJSON_InsertHex_FAIL(void);
+static bool kJSON_InsertRaw_PASS(void);
+static bool kJSON_InsertRaw_FAIL(void);
+#if !CONFIG_KJSON_NO_RAW_CHECK
+static bool kJSON_InsertRawReject_PASS(void);
+#endif
 static bool kJSON_InsertObject_PASS(void);
 static bool kJSON_InsertObject_FAIL(void);
 static bool kJSON_EnterArray_PASS(void);
 static bool kJSON_EnterArray_FAIL(void);
+static bool kJSON_InsertPreparedKey_PASS(void);
+static bool kJSON_InsertPreparedKey_FAIL(void);
+static bool kJSON_InsertLiteralKey_PASS(void);
+static bool kJSON_InsertLiteralKey_FAIL(void);
+static void InsertLiteralKeys(kjson_t *const jsonHandle);
+static bool kJSON_RenderTemplate_PASS(void);
+static bool kJSON_RenderTemplate_FAIL(void);
+static bool kJSON_RenderTemplateGather_PASS(void);
+static bool kJSON_RenderTemplateGather_FAIL(void);
+static bool kJSON_RenderTemplateRollback_PASS(void);
+static bool kJSON_RenderTemplateRollback_FAIL(void);
+static bool kJSON_RenderTemplateUnfinished_PASS(void);
+static bool kJSON_RenderTemplateUnfinished_FAIL(void);
+static bool kJSON_RenderTemplateSlotType_PASS(void);
+static bool kJSON_RenderTemplateSlotType_FAIL(void);
+static bool kJSON_Sink_PASS(void);
+static bool kJSON_Sink_FAIL(void);
+static bool kJSON_Gather_PASS(void);
+static bool kJSON_Gather_FAIL(void);
+static bool kJSON_Batch_PASS(void);
+static bool kJSON_Batch_FAIL(void);
+static bool kJSON_Rollback_PASS(void);
+static bool kJSON_Rollback_FAIL(void);
+static bool kJSON_Measure_PASS(void);
+static bool kJSON_Measure_FAIL(void);
+static void InsertMeasured(kjson_t *const jsonHandle);
+static bool kJSON_Splice_PASS(void);
+static bool kJSON_Splice_FAIL(void);
+static void InsertSpliced(kjson_t *const jsonHandle);
+static bool kJSON_Reformat_PASS(void);
+static bool kJSON_Reformat_FAIL(void);
+static size_t Reformat(char *const buffer, const size_t bufferSize);
+static bool kJSON_Format_PASS(void);
+static bool kJSON_Format_FAIL(void);
+static void InsertFormatted(kjson_t *const jsonHandle);
+#if CONFIG_KJSON_STATS
+static bool kJSON_Stats_PASS(void);
+static bool kJSON_Stats_FAIL(void);
+static void InsertCounted(kjson_t *const jsonHandle);
+#endif
+static bool kJSON_Splice_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"sensor\":{\"name\":\"probe\",\"range\":{\"min\":-40,\"max\":125},\"ok\":true},\"count\":2}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t7,\n"
+                           "\"sensor\":\t{\n"
+                           "\t\"name\":\t\"probe\",\n"
+                           "\t\"range\":\t{\n"
+                           "\t\t\"min\":\t-40,\n"
+                           "\t\t\"max\":\t125\n"
+                           "\t},\n"
+                           "\t\"ok\":\ttrue\n"
+                           "},\n"
+                           "\"count\":\t2\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertSpliced(&json);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Splice_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"sensor\":{\"name\":\"probe\",\"range\":{\"min\":-40,\"max\":125},\"ok\":true},\"count\":2}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t7,\n"
+                           "\"sensor\":\t{\n"
+                           "\t\"name\":\t\"probe\",\n"
+                           "\t\"range\":\t{\n"
+                           "\t\t\"min\":\t-40,\n"
+                           "\t\t\"max\":\t125\n"
+                           "\t},\n"
+                           "\t\"ok\":\ttrue\n"
+                           "},\n"
+                           "\"count\":\t2\n"
+                           "}";
+#endif
+
+   // The fragment that does not fit is not copied
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertSpliced(&json);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static void InsertSpliced(kjson_t *const jsonHandle)
+{
+   // The fragment is built on its own buffer, as it would be on another thread
+   char buffer[128];
+   kjson_t fragment = KJSON_INITIALISE(buffer, sizeof(buffer));
+
+   kJSON_InitFragment(&fragment);
+   kJSON_InsertString(&fragment, "name", "probe");
+   kJSON_EnterObject(&fragment, "range");
+   {
+      kJSON_InsertNumber(&fragment, "min", -40);
+      kJSON_InsertNumber(&fragment, "max", 125);
+   }
+   kJSON_ExitObject(&fragment);
+   kJSON_InsertBoolean(&fragment, "ok", true);
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertNumber(jsonHandle, "id", 7);
+   kJSON_EnterObject(jsonHandle, "sensor");
+   kJSON_Splice(jsonHandle, &fragment);
+   kJSON_ExitObject(jsonHandle);
+   kJSON_InsertNumber(jsonHandle, "count", 2);
+   kJSON_ExitRoot(jsonHandle);
+}
+
+static bool kJSON_Reformat_PASS(void)
+{
+   // The output is in the layout of the other build
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\n"
+                           "\"name\":\t\"a, [b]: {c}\",\n"
+                           "\"values\":\t[1, 2, 3],\n"
+                           "\"items\":\t[\n"
+                           "\t{\n"
+                           "\t\t\"id\":\t1\n"
+                           "\t},\n"
+                           "\t{\n"
+                           "\t}\n"
+                           "],\n"
+                           "\"empty\":\t{\n"
+                           "}\n"
+                           "}";
+#else
+   const char expected[] = "{\"name\":\"a, [b]: {c}\",\"values\":[1,2,3],\"items\":[{\"id\":1},{}],\"empty\":{}}";
+#endif
+
+   char output[sizeof(expected)] = {0};
+   const size_t size = Reformat(output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+   } json = {output, size};
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Reformat_FAIL(void)
+{
+   // The output is in the layout of the other build
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\n"
+                           "\"name\":\t\"a, [b]: {c}\",\n"
+                           "\"values\":\t[1, 2, 3],\n"
+                           "\"items\":\t[\n"
+                           "\t{\n"
+                           "\t\t\"id\":\t1\n"
+                           "\t},\n"
+                           "\t{\n"
+                           "\t}\n"
+                           "],\n"
+                           "\"empty\":\t{\n"
+                           "}\n"
+                           "}";
+#else
+   const char expected[] = "{\"name\":\"a, [b]: {c}\",\"values\":[1,2,3],\"items\":[{\"id\":1},{}],\"empty\":{}}";
+#endif
+
+   char output[sizeof(expected) - 1] = {0};
+   const size_t size = Reformat(output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static size_t Reformat(char *const buffer, const size_t bufferSize)
+{
+   const int values[] = {1, 2, 3};
+   char root[256];
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "name", "a, [b]: {c}");
+   kJSON_InsertArrayInt(jsonHandle, "values", values, array_size(values));
+   kJSON_EnterArray(jsonHandle, "items");
+   {
+      kJSON_EnterObject(jsonHandle, NULL);
+      kJSON_InsertNumber(jsonHandle, "id", 1);
+      kJSON_ExitObject(jsonHandle);
+      kJSON_EnterObject(jsonHandle, NULL);
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitArray(jsonHandle);
+   kJSON_EnterObject(jsonHandle, "empty");
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+
+#if CONFIG_KJSON_SMALLEST
+   return kJSON_Prettify(buffer, bufferSize, root, json.size, NULL);
+#else
+   return kJSON_Minify(buffer, bufferSize, root, json.size);
+#endif
+}
+
+static bool kJSON_Format_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"tags\":[\"a\",\"b\"],\"pos\":{\"x\":1,\"y\":[1,2]}}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\": 7,\n"
+                           "\"tags\": [\"a\", \"b\"],\n"
+                           "\"pos\": {\n"
+                           "  \"x\": 1,\n"
+                           "  \"y\": [1, 2]\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertFormatted(&json);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Format_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"tags\":[\"a\",\"b\"],\"pos\":{\"x\":1,\"y\":[1,2]}}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\": 7,\n"
+                           "\"tags\": [\"a\", \"b\"],\n"
+                           "\"pos\": {\n"
+                           "  \"x\": 1,\n"
+                           "  \"y\": [1, 2]\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertFormatted(&json);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static void InsertFormatted(kjson_t *const jsonHandle)
+{
+   // Two spaces of indentation and a space after the keys, ignored by the compact build
+   static const kjson_format_t format = {.pretty = true, .indent = ' ', .indentWidth = 2, .keySeparator = " "};
+   const char *const tags[] = {"a", "b"};
+   const int values[] = {1, 2};
+   char buffer[8];
+   kjson_key_t id;
+   kJSON_PrepareKey(&id, buffer, sizeof(buffer), "id", KJSON_ASCII_OFF);
+
+   jsonHandle->format = &format;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertNumberWithKey(jsonHandle, &id, 7);
+   kJSON_InsertArrayString(jsonHandle, "tags", tags, 2);
+   kJSON_EnterObject(jsonHandle, "pos");
+   {
+      kJSON_InsertNumber(jsonHandle, "x", 1);
+      kJSON_InsertArrayInt(jsonHandle, "y", values, 2);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+}
+
+#if CONFIG_KJSON_STATS
+static bool kJSON_Stats_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"name\":\"probe\",\"id\":null,\"values\":[1,2]}";
+#else
+   const char expected[] = "{\n"
+                           "\"name\":\t\"probe\",\n"
+                           "\"id\":\tnull,\n"
+                           "\"values\":\t[1, 2]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertCounted(&json);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   // The null number is counted as a null, the closing brackets were reserved within the buffer
+   const kjson_stats_t *const stats = &json.stats;
+   if ((stats->inserts[KJSON_STAT_STRING] != 1) || (stats->inserts[KJSON_STAT_NULL] != 1) || (stats->inserts[KJSON_STAT_NUMBER] != 1) ||
+       stats->truncations || stats->shortfall || (stats->bytes != sizeof(expected) - 1) || (stats->peakSize > sizeof(root)))
+   {
+      printf("\n%s: inserts %zu/%zu/%zu, truncations %zu, shortfall %zu, bytes %zu, peak %zu\n", __func__, stats->inserts[KJSON_STAT_STRING],
+             stats->inserts[KJSON_STAT_NULL], stats->inserts[KJSON_STAT_NUMBER], stats->truncations, stats->shortfall, stats->bytes, stats->peakSize);
+      return false;
+   }
+
+   return true;
+}
+
+static bool kJSON_Stats_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"name\":\"probe\",\"id\":null,\"values\":[1,2]}";
+#else
+   const char expected[] = "{\n"
+                           "\"name\":\t\"probe\",\n"
+                           "\"id\":\tnull,\n"
+                           "\"values\":\t[1, 2]\n"
+                           "}";
+#endif
+
+   // Only the array does not fit, it is one byte short
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertCounted(&json);
+
+   CHECK_JSON_BAD(json, expected);
+
+   const kjson_stats_t *const stats = &json.stats;
+   if ((stats->inserts[KJSON_STAT_NUMBER] != 1) || (stats->truncations != 1) || (stats->shortfall != 1) || (stats->maxShortfall != 1) ||
+       (stats->bytes != json.size))
+   {
+      printf("\n%s: inserts %zu, truncations %zu, shortfall %zu/%zu, bytes %zu\n", __func__, stats->inserts[KJSON_STAT_NUMBER],
+             stats->truncations, stats->shortfall, stats->maxShortfall, stats->bytes);
+      return false;
+   }
+
+   return true;
+}
+
+static void InsertCounted(kjson_t *const jsonHandle)
+{
+   const int values[] = {1, 2};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "name", "probe");
+   kJSON_InsertNumber(jsonHandle, "id", INT_MAX);
+   kJSON_InsertArrayInt(jsonHandle, "values", values, array_size(values));
+   kJSON_ExitRoot(jsonHandle);
+}
+#endif
+
+static bool SinkWrite(void *const context, const char *const data, const size_t size);
 
 int main(void)
 {
@@ -88,25 +502,97 @@ int main(void)
    TEST(kJSON_InsertNumber_FAIL());
    TEST(kJSON_InsertUnsignedNumber_PASS());
    TEST(kJSON_InsertUnsignedNumber_FAIL());
+#if !CONFIG_KJSON_NO_FLOAT
    TEST(kJSON_InsertFloat_PASS());
    TEST(kJSON_InsertFloat_FAIL());
+#endif
    TEST(kJSON_InsertString_PASS());
    TEST(kJSON_InsertString_FAIL());
+   TEST(kJSON_InsertStringEscaped_PASS());
+   TEST(kJSON_InsertStringEscaped_FAIL());
+   TEST(kJSON_InsertStringAscii_PASS());
+   TEST(kJSON_InsertStringAscii_FAIL());
+   TEST(kJSON_InsertStringReject_PASS());
    TEST(kJSON_InsertNull_PASS());
    TEST(kJSON_InsertNull_FAIL());
+#if !CONFIG_KJSON_NO_FLOAT
    TEST(kJSON_InsertNullFloat_PASS());
+#endif
    TEST(kJSON_InsertBoolean_PASS());
    TEST(kJSON_InsertBoolean_FAIL());
    TEST(kJSON_InsertArrayInt_PASS());
    TEST(kJSON_InsertArrayInt_FAIL());
+   TEST(kJSON_InsertArrayUInt_PASS());
+   TEST(kJSON_InsertArrayUInt_FAIL());
+   TEST(kJSON_InsertArrayInt64_PASS());
+   TEST(kJSON_InsertArrayInt64_FAIL());
+   TEST(kJSON_InsertArrayUInt64_PASS());
+   TEST(kJSON_InsertArrayUInt64_FAIL());
+   TEST(kJSON_InsertArrayDigits_PASS());
+   TEST(kJSON_InsertArrayDigits_FAIL());
+   TEST(kJSON_InsertArrayFixedWidth_PASS());
+   TEST(kJSON_InsertArrayFixedWidth_FAIL());
+#if !CONFIG_KJSON_NO_FLOAT
    TEST(kJSON_InsertArrayFloat_PASS());
    TEST(kJSON_InsertArrayFloat_FAIL());
+   TEST(kJSON_InsertArrayFloatLimits_PASS());
+   TEST(kJSON_InsertArrayFloatLimits_FAIL());
+   TEST(kJSON_InsertArrayFloatShortest_PASS());
+   TEST(kJSON_InsertArrayFloatShortest_FAIL());
+   TEST(kJSON_InsertArrayDoubleLimits_PASS());
+   TEST(kJSON_InsertArrayDoubleLimits_FAIL());
+   TEST(kJSON_InsertArrayDoubleShortest_PASS());
+   TEST(kJSON_InsertArrayDoubleShortest_FAIL());
+#endif
    TEST(kJSON_InsertArrayString_PASS());
    TEST(kJSON_InsertArrayString_FAIL());
+   TEST(kJSON_InsertBase64_PASS());
+   TEST(kJSON_InsertBase64_FAIL());
+   TEST(kJSON_InsertHex_PASS());
+   TEST(kJSON_InsertHex_FAIL());
+   TEST(kJSON_InsertRaw_PASS());
+   TEST(kJSON_InsertRaw_FAIL());
+#if !CONFIG_KJSON_NO_RAW_CHECK
+   TEST(kJSON_InsertRawReject_PASS());
+#endif
    TEST(kJSON_InsertObject_PASS());
    TEST(kJSON_InsertObject_FAIL());
    TEST(kJSON_EnterArray_PASS());
    TEST(kJSON_EnterArray_FAIL());
+   TEST(kJSON_InsertPreparedKey_PASS());
+   TEST(kJSON_InsertPreparedKey_FAIL());
+   TEST(kJSON_InsertLiteralKey_PASS());
+   TEST(kJSON_InsertLiteralKey_FAIL());
+   TEST(kJSON_RenderTemplate_PASS());
+   TEST(kJSON_RenderTemplate_FAIL());
+   TEST(kJSON_RenderTemplateGather_PASS());
+   TEST(kJSON_RenderTemplateGather_FAIL());
+   TEST(kJSON_RenderTemplateRollback_PASS());
+   TEST(kJSON_RenderTemplateRollback_FAIL());
+   TEST(kJSON_RenderTemplateUnfinished_PASS());
+   TEST(kJSON_RenderTemplateUnfinished_FAIL());
+   TEST(kJSON_RenderTemplateSlotType_PASS());
+   TEST(kJSON_RenderTemplateSlotType_FAIL());
+   TEST(kJSON_Sink_PASS());
+   TEST(kJSON_Sink_FAIL());
+   TEST(kJSON_Gather_PASS());
+   TEST(kJSON_Gather_FAIL());
+   TEST(kJSON_Batch_PASS());
+   TEST(kJSON_Batch_FAIL());
+   TEST(kJSON_Rollback_PASS());
+   TEST(kJSON_Rollback_FAIL());
+   TEST(kJSON_Measure_PASS());
+   TEST(kJSON_Measure_FAIL());
+   TEST(kJSON_Splice_PASS());
+   TEST(kJSON_Splice_FAIL());
+   TEST(kJSON_Reformat_PASS());
+   TEST(kJSON_Reformat_FAIL());
+   TEST(kJSON_Format_PASS());
+   TEST(kJSON_Format_FAIL());
+#if CONFIG_KJSON_STATS
+   TEST(kJSON_Stats_PASS());
+   TEST(kJSON_Stats_FAIL());
+#endif
 
    return result;
 }
@@ -211,6 +697,7 @@ static bool kJSON_InsertUnsignedNumber_FAIL(void)
    return true;
 }
 
+#if !CONFIG_KJSON_NO_FLOAT
 static bool kJSON_InsertFloat_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
@@ -260,6 +747,7 @@ static bool kJSON_InsertFloat_FAIL(void)
 
    return true;
 }
+#endif
 
 static bool kJSON_InsertString_PASS(void)
 {
@@ -309,22 +797,23 @@ static bool kJSON_InsertString_FAIL(void)
    return true;
 }
 
-static bool kJSON_InsertNull_PASS(void)
+static bool kJSON_InsertStringEscaped_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"null\":null}";
+   const char expected[] = "{\"\\\"quoted\\\" key\":\"C:\\\\tmp\\n\\tline\\u0001 with a longer clean run to scan\"}";
 #else
    const char expected[] = "{\n"
-                           "\"null\":\tnull\n"
+                           "\"\\\"quoted\\\" key\":\t\"C:\\\\tmp\\n\\tline\\u0001 with a longer clean run to scan\"\n"
                            "}";
 #endif
 
    char root[sizeof(expected)] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
+   const char *string = "C:\\tmp\n\tline\x01 with a longer clean run to scan";
 
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertNull(jsonHandle, "null");
+   kJSON_InsertString(jsonHandle, "\"quoted\" key", string);
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -332,22 +821,23 @@ static bool kJSON_InsertNull_PASS(void)
    return true;
 }
 
-static bool kJSON_InsertNull_FAIL(void)
+static bool kJSON_InsertStringEscaped_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"null\":null}";
+   const char expected[] = "{\"\\\"quoted\\\" key\":\"C:\\\\tmp\\n\\tline\\u0001 with a longer clean run to scan\"}";
 #else
    const char expected[] = "{\n"
-                           "\"null\":\tnull\n"
+                           "\"\\\"quoted\\\" key\":\t\"C:\\\\tmp\\n\\tline\\u0001 with a longer clean run to scan\"\n"
                            "}";
 #endif
 
    char root[sizeof(expected) - 1] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
+   const char *string = "C:\\tmp\n\tline\x01 with a longer clean run to scan";
 
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertNull(jsonHandle, "null");
+   kJSON_InsertString(jsonHandle, "\"quoted\" key", string);
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_BAD(json, expected);
@@ -355,23 +845,24 @@ static bool kJSON_InsertNull_FAIL(void)
    return true;
 }
 
-static bool kJSON_InsertNullFloat_PASS(void)
+static bool kJSON_InsertStringAscii_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"number\":null}";
+   const char expected[] = "{\"car\":\"\\ud83d\\ude97 caf\\u00e9 \\ufffd\"}";
 #else
    const char expected[] = "{\n"
-                           "\"number\":\tnull\n"
+                           "\"car\":\t\"\\ud83d\\ude97 caf\\u00e9 \\ufffd\"\n"
                            "}";
 #endif
+
    char root[sizeof(expected)] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
+   const char *string = "\xF0\x9F\x9A\x97 caf\xC3\xA9 \xC3";
 
-   json.nullFloatValue = -99999.0f;
-   float number = -99999.0f;
+   json.ascii = KJSON_ASCII_REPLACE;
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertFloat(jsonHandle, "number", number, 2);
+   kJSON_InsertString(jsonHandle, "car", string);
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -379,63 +870,69 @@ static bool kJSON_InsertNullFloat_PASS(void)
    return true;
 }
 
-static bool kJSON_InsertBoolean_PASS(void)
+static bool kJSON_InsertStringAscii_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"true\":true,\"false\":false}";
+   const char expected[] = "{\"car\":\"\\ud83d\\ude97 caf\\u00e9 \\ufffd\"}";
 #else
    const char expected[] = "{\n"
-                           "\"true\":\ttrue,\n"
-                           "\"false\":\tfalse\n"
+                           "\"car\":\t\"\\ud83d\\ude97 caf\\u00e9 \\ufffd\"\n"
                            "}";
 #endif
 
-   char root[sizeof(expected)] = {0};
+   char root[sizeof(expected) - 1] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
+   const char *string = "\xF0\x9F\x9A\x97 caf\xC3\xA9 \xC3";
 
+   json.ascii = KJSON_ASCII_REPLACE;
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertBoolean(jsonHandle, "true", true);
-   kJSON_InsertBoolean(jsonHandle, "false", false);
+   kJSON_InsertString(jsonHandle, "car", string);
    kJSON_ExitRoot(jsonHandle);
 
-   CHECK_JSON_GOOD(json, expected);
+   CHECK_JSON_BAD(json, expected);
 
    return true;
 }
 
-static bool kJSON_InsertBoolean_FAIL(void)
+static bool kJSON_InsertStringReject_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"true\":true,\"false\":false}";
+   const char expected[] = "{\"valid\":\"caf\\u00e9\"}";
 #else
    const char expected[] = "{\n"
-                           "\"true\":\ttrue,\n"
-                           "\"false\":\tfalse\n"
+                           "\"valid\":\t\"caf\\u00e9\"\n"
                            "}";
 #endif
 
-   char root[sizeof(expected) - 1] = {0};
+   char root[sizeof(expected)] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
+   json.ascii = KJSON_ASCII_REJECT;
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertBoolean(jsonHandle, "true", true);
-   kJSON_InsertBoolean(jsonHandle, "false", false);
+   kJSON_InsertString(jsonHandle, "invalid", "caf\xC3");
+   kJSON_InsertString(jsonHandle, "valid", "caf\xC3\xA9");
    kJSON_ExitRoot(jsonHandle);
 
-   CHECK_JSON_BAD(json, expected);
+   CHECK_JSON_GOOD(json, expected);
+   if (!json.rejected)
+   {
+      printf("\n%s: didn't reject\n", __func__);
+      printf("File: ./%s:%d\n\n", __FILE__, __LINE__);
+      return false;
+   }
 
    return true;
 }
 
-static bool kJSON_InsertArrayInt_PASS(void)
+static bool kJSON_InsertNull_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"digits\":[0,1,2,3,4,5,6,7,8,null]}";
+   const char expected[] = "{\"null\":null}";
 #else
    const char expected[] = "{\n"
-                           "\"digits\":\t[0, 1, 2, 3, 4, 5, 6, 7, 8, null]\n"
+                           "\"null\":\tnull\n"
                            "}";
 #endif
 
@@ -443,10 +940,8 @@ static bool kJSON_InsertArrayInt_PASS(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
-   int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, INT_MAX};
-
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_InsertNull(jsonHandle, "null");
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -454,13 +949,13 @@ static bool kJSON_InsertArrayInt_PASS(void)
    return true;
 }
 
-static bool kJSON_InsertArrayInt_FAIL(void)
+static bool kJSON_InsertNull_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"digits\":[0,1,2,3,4,5,6,7,8,null]}";
+   const char expected[] = "{\"null\":null}";
 #else
    const char expected[] = "{\n"
-                           "\"digits\":\t[0, 1, 2, 3, 4, 5, 6, 7, 8, null]\n"
+                           "\"null\":\tnull\n"
                            "}";
 #endif
 
@@ -468,10 +963,8 @@ static bool kJSON_InsertArrayInt_FAIL(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
-   int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, INT_MAX};
-
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_InsertNull(jsonHandle, "null");
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_BAD(json, expected);
@@ -479,26 +972,50 @@ static bool kJSON_InsertArrayInt_FAIL(void)
    return true;
 }
 
-static bool kJSON_InsertArrayFloat_PASS(void)
+#if !CONFIG_KJSON_NO_FLOAT
+static bool kJSON_InsertNullFloat_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"digits\":[0.0,1.1,2.3,3.3,4.4,5.5,6.6,7.7,8.8,null]}";
+   const char expected[] = "{\"number\":null}";
 #else
    const char expected[] = "{\n"
-                           "\"digits\":\t[0.0, 1.1, 2.3, 3.3, 4.4, 5.5, 6.6, 7.7, 8.8, null]\n"
+                           "\"number\":\tnull\n"
                            "}";
 #endif
-
    char root[sizeof(expected)] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
    json.nullFloatValue = -99999.0f;
+   float number = -99999.0f;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertFloat(jsonHandle, "number", number, 2);
+   kJSON_ExitRoot(jsonHandle);
 
-   float digits[] = {0.0f, 1.1222f, 2.29999f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f, -99999.0f};
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+#endif
+
+static bool kJSON_InsertBoolean_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"true\":true,\"false\":false}";
+#else
+   const char expected[] = "{\n"
+                           "\"true\":\ttrue,\n"
+                           "\"false\":\tfalse\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
 
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertArrayFloat(jsonHandle, "digits", digits, array_size(digits), 1);
+   kJSON_InsertBoolean(jsonHandle, "true", true);
+   kJSON_InsertBoolean(jsonHandle, "false", false);
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -506,13 +1023,14 @@ static bool kJSON_InsertArrayFloat_PASS(void)
    return true;
 }
 
-static bool kJSON_InsertArrayFloat_FAIL(void)
+static bool kJSON_InsertBoolean_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"digits\":[0.0,1.1,2.3,3.3,4.4,5.5,6.6,7.7,8.8,null]}";
+   const char expected[] = "{\"true\":true,\"false\":false}";
 #else
    const char expected[] = "{\n"
-                           "\"digits\":\t[0.0, 1.1, 2.3, 3.3, 4.4, 5.5, 6.6, 7.7, 8.8, null]\n"
+                           "\"true\":\ttrue,\n"
+                           "\"false\":\tfalse\n"
                            "}";
 #endif
 
@@ -520,12 +1038,9 @@ static bool kJSON_InsertArrayFloat_FAIL(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
-   json.nullFloatValue = -99999.0f;
-
-   float digits[] = {0.0f, 1.1222f, 2.29999f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f, -99999.0f};
-
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertArrayFloat(jsonHandle, "digits", digits, array_size(digits), 1);
+   kJSON_InsertBoolean(jsonHandle, "true", true);
+   kJSON_InsertBoolean(jsonHandle, "false", false);
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_BAD(json, expected);
@@ -533,13 +1048,13 @@ static bool kJSON_InsertArrayFloat_FAIL(void)
    return true;
 }
 
-static bool kJSON_InsertArrayString_PASS(void)
+static bool kJSON_InsertArrayInt_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"digits\":[\"0\",\"1\",\"2\",\"3\",\"4\",\"5\",\"6\",\"7\",\"8\",null]}";
+   const char expected[] = "{\"digits\":[0,1,2,3,4,5,6,7,8,null]}";
 #else
    const char expected[] = "{\n"
-                           "\"digits\":\t[\"0\", \"1\", \"2\", \"3\", \"4\", \"5\", \"6\", \"7\", \"8\", null]\n"
+                           "\"digits\":\t[0, 1, 2, 3, 4, 5, 6, 7, 8, null]\n"
                            "}";
 #endif
 
@@ -547,10 +1062,10 @@ static bool kJSON_InsertArrayString_PASS(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
-   const char *digits[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", NULL};
+   int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, INT_MAX};
 
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertArrayString(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -558,13 +1073,13 @@ static bool kJSON_InsertArrayString_PASS(void)
    return true;
 }
 
-static bool kJSON_InsertArrayString_FAIL(void)
+static bool kJSON_InsertArrayInt_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"digits\":[\"0\",\"1\",\"2\",\"3\",\"4\",\"5\",\"6\",\"7\",\"8\",null]}";
+   const char expected[] = "{\"digits\":[0,1,2,3,4,5,6,7,8,null]}";
 #else
    const char expected[] = "{\n"
-                           "\"digits\":\t[\"0\", \"1\", \"2\", \"3\", \"4\", \"5\", \"6\", \"7\", \"8\", null]\n"
+                           "\"digits\":\t[0, 1, 2, 3, 4, 5, 6, 7, 8, null]\n"
                            "}";
 #endif
 
@@ -572,10 +1087,10 @@ static bool kJSON_InsertArrayString_FAIL(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
-   const char *digits[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", NULL};
+   int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, INT_MAX};
 
    kJSON_InitRoot(jsonHandle);
-   kJSON_InsertArrayString(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_BAD(json, expected);
@@ -583,15 +1098,13 @@ static bool kJSON_InsertArrayString_FAIL(void)
    return true;
 }
 
-static bool kJSON_InsertObject_PASS(void)
+static bool kJSON_InsertArrayUInt_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"object\":{\"key\":\"value\"}}";
+   const char expected[] = "{\"limits\":[0,9,10,99,100,2147483647,4294967294,null]}";
 #else
    const char expected[] = "{\n"
-                           "\"object\":\t{\n"
-                           "\t\"key\":\t\"value\"\n"
-                           "}\n"
+                           "\"limits\":\t[0, 9, 10, 99, 100, 2147483647, 4294967294, null]\n"
                            "}";
 #endif
 
@@ -599,14 +1112,10 @@ static bool kJSON_InsertObject_PASS(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
-   kJSON_InitRoot(jsonHandle);
-
-   kJSON_EnterObject(jsonHandle, "object");
-   {
-      kJSON_InsertString(jsonHandle, "key", "value");
-   }
-   kJSON_ExitObject(jsonHandle);
+   unsigned int limits[] = {0, 9, 10, 99, 100, INT_MAX, UINT_MAX - 1, UINT_MAX};
 
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayUInt(jsonHandle, "limits", limits, array_size(limits));
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -614,15 +1123,13 @@ static bool kJSON_InsertObject_PASS(void)
    return true;
 }
 
-static bool kJSON_InsertObject_FAIL(void)
+static bool kJSON_InsertArrayUInt_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"object\":{\"key\":\"value\"}}";
+   const char expected[] = "{\"limits\":[0,9,10,99,100,2147483647,4294967294,null]}";
 #else
    const char expected[] = "{\n"
-                           "\"object\":\t{\n"
-                           "\t\"key\": \"value\"\n"
-                           "}\n"
+                           "\"limits\":\t[0, 9, 10, 99, 100, 2147483647, 4294967294, null]\n"
                            "}";
 #endif
 
@@ -630,14 +1137,60 @@ static bool kJSON_InsertObject_FAIL(void)
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
+   unsigned int limits[] = {0, 9, 10, 99, 100, INT_MAX, UINT_MAX - 1, UINT_MAX};
+
    kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayUInt(jsonHandle, "limits", limits, array_size(limits));
+   kJSON_ExitRoot(jsonHandle);
 
-   kJSON_EnterObject(jsonHandle, "object");
-   {
-      kJSON_InsertString(jsonHandle, "key", "value");
-   }
-   kJSON_ExitObject(jsonHandle);
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayInt64_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[-9223372036854775808,-1,0,9,10,9223372036854775806,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[-9223372036854775808, -1, 0, 9, 10, 9223372036854775806, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   int64_t limits[] = {INT64_MIN, -1, 0, 9, 10, INT64_MAX - 1, INT64_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt64(jsonHandle, "limits", limits, array_size(limits));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
 
+   return true;
+}
+
+static bool kJSON_InsertArrayInt64_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[-9223372036854775808,-1,0,9,10,9223372036854775806,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[-9223372036854775808, -1, 0, 9, 10, 9223372036854775806, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   int64_t limits[] = {INT64_MIN, -1, 0, 9, 10, INT64_MAX - 1, INT64_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt64(jsonHandle, "limits", limits, array_size(limits));
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_BAD(json, expected);
@@ -645,44 +1198,75 @@ static bool kJSON_InsertObject_FAIL(void)
    return true;
 }
 
-static bool kJSON_EnterArray_PASS(void)
+static bool kJSON_InsertArrayUInt64_PASS(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"array\":[{\"foo\":\"bar\"},{\"baz\":123}]}";
+   const char expected[] = "{\"limits\":[0,4294967295,4294967296,10000000000000000000,18446744073709551614,null]}";
 #else
    const char expected[] = "{\n"
-                           "\"array\":\t[\n"
-                           "\t{\n"
-                           "\t\t\"foo\":\t\"bar\"\n"
-                           "\t},\n"
-                           "\t{\n"
-                           "\t\t\"baz\":\t123\n"
-                           "\t}\n"
-                           "]\n"
+                           "\"limits\":\t[0, 4294967295, 4294967296, 10000000000000000000, 18446744073709551614, null]\n"
                            "}";
 #endif
+
    char root[sizeof(expected)] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
 
+   uint64_t limits[] = {0, UINT32_MAX, (uint64_t)UINT32_MAX + 1, 10000000000000000000ull, UINT64_MAX - 1, UINT64_MAX};
+
    kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayUInt64(jsonHandle, "limits", limits, array_size(limits));
+   kJSON_ExitRoot(jsonHandle);
 
-   kJSON_EnterArray(jsonHandle, "array");
-   {
-      kJSON_EnterObject(jsonHandle, NULL);
-      {
-         kJSON_InsertString(jsonHandle, "foo", "bar");
-      }
-      kJSON_ExitObject(jsonHandle);
+   CHECK_JSON_GOOD(json, expected);
 
-      kJSON_EnterObject(jsonHandle, NULL);
-      {
-         kJSON_InsertNumber(jsonHandle, "baz", 123);
-      }
-      kJSON_ExitObject(jsonHandle);
-   }
-   kJSON_ExitArray(jsonHandle);
+   return true;
+}
+
+static bool kJSON_InsertArrayUInt64_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[0,4294967295,4294967296,10000000000000000000,18446744073709551614,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[0, 4294967295, 4294967296, 10000000000000000000, 18446744073709551614, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   uint64_t limits[] = {0, UINT32_MAX, (uint64_t)UINT32_MAX + 1, 10000000000000000000ull, UINT64_MAX - 1, UINT64_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayUInt64(jsonHandle, "limits", limits, array_size(limits));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayDigits_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[0,9,10,99,100,999,1000,9999,10000,99999,100000,999999,1000000,9999999,10000000,99999999,100000000,999999999,1000000000,-1,-9,-10,-99999,-100000,-2147483647,-2147483648,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[0, 9, 10, 99, 100, 999, 1000, 9999, 10000, 99999, 100000, 999999, 1000000, 9999999, 10000000, 99999999, 100000000, 999999999, 1000000000, -1, -9, -10, -99999, -100000, -2147483647, -2147483648, null]\n"
+                           "}";
+#endif
+
+   // Every digit count, across more than one block of elements
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const int digits[] = {0, 9, 10, 99, 100, 999, 1000, 9999, 10000, 99999, 100000, 999999, 1000000, 9999999, 10000000, 99999999, 100000000, 999999999, 1000000000, -1, -9, -10, -99999, -100000, -2147483647, INT_MIN, INT_MAX};
 
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
    kJSON_ExitRoot(jsonHandle);
 
    CHECK_JSON_GOOD(json, expected);
@@ -690,45 +1274,1928 @@ static bool kJSON_EnterArray_PASS(void)
    return true;
 }
 
-static bool kJSON_EnterArray_FAIL(void)
+static bool kJSON_InsertArrayDigits_FAIL(void)
 {
 #if CONFIG_KJSON_SMALLEST
-   const char expected[] = "{\"array\":[{\"foo\":\"bar\"},{\"baz\":123}]}";
+   const char expected[] = "{\"digits\":[0,9,10,99,100,999,1000,9999,10000,99999,100000,999999,1000000,9999999,10000000,99999999,100000000,999999999,1000000000,-1,-9,-10,-99999,-100000,-2147483647,-2147483648,null]}";
 #else
    const char expected[] = "{\n"
-                           "\"array\":\t[\n"
-                           "\t{\n"
-                           "\t\t\"foo\":\t\"bar\"\n"
-                           "\t},\n"
-                           "\t{\n"
-                           "\t\t\"baz\":\t123\n"
-                           "\t}\n"
-                           "]\n"
+                           "\"digits\":\t[0, 9, 10, 99, 100, 999, 1000, 9999, 10000, 99999, 100000, 999999, 1000000, 9999999, 10000000, 99999999, 100000000, 999999999, 1000000000, -1, -9, -10, -99999, -100000, -2147483647, -2147483648, null]\n"
                            "}";
 #endif
+
+   // Every digit count, across more than one block of elements
    char root[sizeof(expected) - 1] = {0};
    kjson_t json = KJSON_INITIALISE(root, sizeof(root));
    kjson_t *jsonHandle = &json;
+
+   const int digits[] = {0, 9, 10, 99, 100, 999, 1000, 9999, 10000, 99999, 100000, 999999, 1000000, 9999999, 10000000, 99999999, 100000000, 999999999, 1000000000, -1, -9, -10, -99999, -100000, -2147483647, INT_MIN, INT_MAX};
+
    kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_ExitRoot(jsonHandle);
 
-   kJSON_EnterArray(jsonHandle, "array");
-   {
-      kJSON_EnterObject(jsonHandle, NULL);
-      {
-         kJSON_InsertString(jsonHandle, "foo", "bar");
-      }
-      kJSON_ExitObject(jsonHandle);
+   CHECK_JSON_BAD(json, expected);
 
-      kJSON_EnterObject(jsonHandle, NULL);
-      {
-         kJSON_InsertNumber(jsonHandle, "baz", 123);
-      }
-      kJSON_ExitObject(jsonHandle);
-   }
-   kJSON_ExitArray(jsonHandle);
+   return true;
+}
 
+static bool kJSON_InsertArrayFixedWidth_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"i8\":[-128,-1,0,126,null],\"u8\":[0,9,254,null],\"i16\":[-32768,10,32766,null],\"u16\":[0,65534,null],"
+                           "\"i32\":[-2147483648,99,2147483646,null],\"u32\":[0,4294967294,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"i8\":\t[-128, -1, 0, 126, null],\n"
+                           "\"u8\":\t[0, 9, 254, null],\n"
+                           "\"i16\":\t[-32768, 10, 32766, null],\n"
+                           "\"u16\":\t[0, 65534, null],\n"
+                           "\"i32\":\t[-2147483648, 99, 2147483646, null],\n"
+                           "\"u32\":\t[0, 4294967294, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const int8_t i8[] = {INT8_MIN, -1, 0, INT8_MAX - 1, INT8_MAX};
+   const uint8_t u8[] = {0, 9, UINT8_MAX - 1, UINT8_MAX};
+   const int16_t i16[] = {INT16_MIN, 10, INT16_MAX - 1, INT16_MAX};
+   const uint16_t u16[] = {0, UINT16_MAX - 1, UINT16_MAX};
+   const int32_t i32[] = {INT32_MIN, 99, INT32_MAX - 1, INT32_MAX};
+   const uint32_t u32[] = {0, UINT32_MAX - 1, UINT32_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt8(jsonHandle, "i8", i8, array_size(i8));
+   kJSON_InsertArrayUInt8(jsonHandle, "u8", u8, array_size(u8));
+   kJSON_InsertArrayInt16(jsonHandle, "i16", i16, array_size(i16));
+   kJSON_InsertArrayUInt16(jsonHandle, "u16", u16, array_size(u16));
+   kJSON_InsertArrayInt32(jsonHandle, "i32", i32, array_size(i32));
+   kJSON_InsertArrayUInt32(jsonHandle, "u32", u32, array_size(u32));
    kJSON_ExitRoot(jsonHandle);
 
-   CHECK_JSON_BAD(json, expected);
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayFixedWidth_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"i8\":[-128,-1,0,126,null],\"u8\":[0,9,254,null],\"i16\":[-32768,10,32766,null],\"u16\":[0,65534,null],"
+                           "\"i32\":[-2147483648,99,2147483646,null],\"u32\":[0,4294967294,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"i8\":\t[-128, -1, 0, 126, null],\n"
+                           "\"u8\":\t[0, 9, 254, null],\n"
+                           "\"i16\":\t[-32768, 10, 32766, null],\n"
+                           "\"u16\":\t[0, 65534, null],\n"
+                           "\"i32\":\t[-2147483648, 99, 2147483646, null],\n"
+                           "\"u32\":\t[0, 4294967294, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const int8_t i8[] = {INT8_MIN, -1, 0, INT8_MAX - 1, INT8_MAX};
+   const uint8_t u8[] = {0, 9, UINT8_MAX - 1, UINT8_MAX};
+   const int16_t i16[] = {INT16_MIN, 10, INT16_MAX - 1, INT16_MAX};
+   const uint16_t u16[] = {0, UINT16_MAX - 1, UINT16_MAX};
+   const int32_t i32[] = {INT32_MIN, 99, INT32_MAX - 1, INT32_MAX};
+   const uint32_t u32[] = {0, UINT32_MAX - 1, UINT32_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt8(jsonHandle, "i8", i8, array_size(i8));
+   kJSON_InsertArrayUInt8(jsonHandle, "u8", u8, array_size(u8));
+   kJSON_InsertArrayInt16(jsonHandle, "i16", i16, array_size(i16));
+   kJSON_InsertArrayUInt16(jsonHandle, "u16", u16, array_size(u16));
+   kJSON_InsertArrayInt32(jsonHandle, "i32", i32, array_size(i32));
+   kJSON_InsertArrayUInt32(jsonHandle, "u32", u32, array_size(u32));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+#if !CONFIG_KJSON_NO_FLOAT
+static bool kJSON_InsertArrayFloat_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[0.0,1.1,2.3,3.3,4.4,5.5,6.6,7.7,8.8,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[0.0, 1.1, 2.3, 3.3, 4.4, 5.5, 6.6, 7.7, 8.8, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   json.nullFloatValue = -99999.0f;
+
+   float digits[] = {0.0f, 1.1222f, 2.29999f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f, -99999.0f};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayFloat(jsonHandle, "digits", digits, array_size(digits), 1);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayFloat_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[0.0,1.1,2.3,3.3,4.4,5.5,6.6,7.7,8.8,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[0.0, 1.1, 2.3, 3.3, 4.4, 5.5, 6.6, 7.7, 8.8, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   json.nullFloatValue = -99999.0f;
+
+   float digits[] = {0.0f, 1.1222f, 2.29999f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f, -99999.0f};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayFloat(jsonHandle, "digits", digits, array_size(digits), 1);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayFloatLimits_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[-0.500,0.125,-0.000,100000002004087734272.000,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[-0.500, 0.125, -0.000, 100000002004087734272.000, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const float inf = 1.0f / 0.0f;
+   float limits[] = {-0.5f, 0.125f, -0.0001f, 1e20f, inf};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayFloat(jsonHandle, "limits", limits, array_size(limits), 3);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayFloatLimits_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[-0.500,0.125,-0.000,100000002004087734272.000,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[-0.500, 0.125, -0.000, 100000002004087734272.000, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const float inf = 1.0f / 0.0f;
+   float limits[] = {-0.5f, 0.125f, -0.0001f, 1e20f, inf};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayFloat(jsonHandle, "limits", limits, array_size(limits), 3);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayFloatShortest_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"shortest\":[0.1,-1.5,100,123456.7,0.000001,1e-7,1e+21,-0]}";
+#else
+   const char expected[] = "{\n"
+                           "\"shortest\":\t[0.1, -1.5, 100, 123456.7, 0.000001, 1e-7, 1e+21, -0]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   float values[] = {0.1f, -1.5f, 100.0f, 123456.7f, 1e-6f, 1e-7f, 1e21f, -0.0f};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayFloat(jsonHandle, "shortest", values, array_size(values), KJSON_DECIMALS_SHORTEST);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayFloatShortest_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"shortest\":[0.1,-1.5,100,123456.7,0.000001,1e-7,1e+21,-0]}";
+#else
+   const char expected[] = "{\n"
+                           "\"shortest\":\t[0.1, -1.5, 100, 123456.7, 0.000001, 1e-7, 1e+21, -0]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   float values[] = {0.1f, -1.5f, 100.0f, 123456.7f, 1e-6f, 1e-7f, 1e21f, -0.0f};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayFloat(jsonHandle, "shortest", values, array_size(values), KJSON_DECIMALS_SHORTEST);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayDoubleLimits_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[-0.500,0.125,9007199254740992.000,99999999999999991611392.000,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[-0.500, 0.125, 9007199254740992.000, 99999999999999991611392.000, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   double values[] = {-0.5, 0.125, 9007199254740993.0, 1e23, DBL_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayDouble(jsonHandle, "limits", values, array_size(values), 3);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayDoubleLimits_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"limits\":[-0.500,0.125,9007199254740992.000,99999999999999991611392.000,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"limits\":\t[-0.500, 0.125, 9007199254740992.000, 99999999999999991611392.000, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   double values[] = {-0.5, 0.125, 9007199254740993.0, 1e23, DBL_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayDouble(jsonHandle, "limits", values, array_size(values), 3);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayDoubleShortest_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"shortest\":[0.1,-2.5,0.3333333333333333,1e+100,5e-324,301579632.2384682,7.120236347223045e-307,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"shortest\":\t[0.1, -2.5, 0.3333333333333333, 1e+100, 5e-324, 301579632.2384682, 7.120236347223045e-307, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   double values[] = {0.1, -2.5, 1.0 / 3.0, 1e100, 5e-324, 301579632.2384682, 7.120236347223045e-307, DBL_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayDouble(jsonHandle, "shortest", values, array_size(values), KJSON_DECIMALS_SHORTEST);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayDoubleShortest_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"shortest\":[0.1,-2.5,0.3333333333333333,1e+100,5e-324,301579632.2384682,7.120236347223045e-307,null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"shortest\":\t[0.1, -2.5, 0.3333333333333333, 1e+100, 5e-324, 301579632.2384682, 7.120236347223045e-307, null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   double values[] = {0.1, -2.5, 1.0 / 3.0, 1e100, 5e-324, 301579632.2384682, 7.120236347223045e-307, DBL_MAX};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayDouble(jsonHandle, "shortest", values, array_size(values), KJSON_DECIMALS_SHORTEST);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+#endif
+
+static bool kJSON_InsertArrayString_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[\"0\",\"1\",\"2\",\"3\",\"4\",\"5\",\"6\",\"7\",\"8\",null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[\"0\", \"1\", \"2\", \"3\", \"4\", \"5\", \"6\", \"7\", \"8\", null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const char *digits[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", NULL};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayString(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertArrayString_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[\"0\",\"1\",\"2\",\"3\",\"4\",\"5\",\"6\",\"7\",\"8\",null]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[\"0\", \"1\", \"2\", \"3\", \"4\", \"5\", \"6\", \"7\", \"8\", null]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   const char *digits[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", NULL};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayString(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertBase64_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"blob\":\"ACVKb5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxeoPNFl+o8jtEjdcgabL8BU=\","
+                           "\"blobs\":[\"ACVKb5S53gMoTXKXvOEGK1B1mr8=\",null,\"b5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxQ==\",\"\"]}";
+#else
+   const char expected[] = "{\n"
+                           "\"blob\":\t\"ACVKb5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxeoPNFl+o8jtEjdcgabL8BU=\",\n"
+                           "\"blobs\":\t[\"ACVKb5S53gMoTXKXvOEGK1B1mr8=\", null, \"b5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxQ==\", \"\"]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   // Long enough for the SIMD blocks, with one and two padding characters
+   uint8_t data[50];
+   for (size_t i = 0; i < array_size(data); i++)
+   {
+      data[i] = (uint8_t)(i * 37);
+   }
+   const void *blobs[] = {data, NULL, data + 3, data};
+   const size_t lengths[] = {20, 0, 31, 0};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertBase64(jsonHandle, "blob", data, sizeof(data));
+   kJSON_InsertArrayBase64(jsonHandle, "blobs", blobs, lengths, array_size(blobs));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertBase64_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"blob\":\"ACVKb5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxeoPNFl+o8jtEjdcgabL8BU=\","
+                           "\"blobs\":[\"ACVKb5S53gMoTXKXvOEGK1B1mr8=\",null,\"b5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxQ==\",\"\"]}";
+#else
+   const char expected[] = "{\n"
+                           "\"blob\":\t\"ACVKb5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxeoPNFl+o8jtEjdcgabL8BU=\",\n"
+                           "\"blobs\":\t[\"ACVKb5S53gMoTXKXvOEGK1B1mr8=\", null, \"b5S53gMoTXKXvOEGK1B1mr/kCS5TeJ3C5wwxVnugxQ==\", \"\"]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   // Long enough for the SIMD blocks, with one and two padding characters
+   uint8_t data[50];
+   for (size_t i = 0; i < array_size(data); i++)
+   {
+      data[i] = (uint8_t)(i * 37);
+   }
+   const void *blobs[] = {data, NULL, data + 3, data};
+   const size_t lengths[] = {20, 0, 31, 0};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertBase64(jsonHandle, "blob", data, sizeof(data));
+   kJSON_InsertArrayBase64(jsonHandle, "blobs", blobs, lengths, array_size(blobs));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertHex_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digest\":\"00254a6f94b9de03284d7297bce1062b50759abfe4092e53789dc2e70c31567ba0c5ea0f34597ea3\","
+                           "\"registers\":[\"00254a6f94b9de03284d7297bce1062b\",null,\"b9de03\"]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digest\":\t\"00254a6f94b9de03284d7297bce1062b50759abfe4092e53789dc2e70c31567ba0c5ea0f34597ea3\",\n"
+                           "\"registers\":\t[\"00254a6f94b9de03284d7297bce1062b\", null, \"b9de03\"]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   // Long enough for the SIMD blocks and a scalar tail
+   uint8_t data[40];
+   for (size_t i = 0; i < array_size(data); i++)
+   {
+      data[i] = (uint8_t)(i * 37);
+   }
+   const void *registers[] = {data, NULL, data + 5};
+   const size_t lengths[] = {16, 0, 3};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertHex(jsonHandle, "digest", data, sizeof(data));
+   kJSON_InsertArrayHex(jsonHandle, "registers", registers, lengths, array_size(registers));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertHex_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digest\":\"00254a6f94b9de03284d7297bce1062b50759abfe4092e53789dc2e70c31567ba0c5ea0f34597ea3\","
+                           "\"registers\":[\"00254a6f94b9de03284d7297bce1062b\",null,\"b9de03\"]}";
+#else
+   const char expected[] = "{\n"
+                           "\"digest\":\t\"00254a6f94b9de03284d7297bce1062b50759abfe4092e53789dc2e70c31567ba0c5ea0f34597ea3\",\n"
+                           "\"registers\":\t[\"00254a6f94b9de03284d7297bce1062b\", null, \"b9de03\"]\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   // Long enough for the SIMD blocks and a scalar tail
+   uint8_t data[40];
+   for (size_t i = 0; i < array_size(data); i++)
+   {
+      data[i] = (uint8_t)(i * 37);
+   }
+   const void *registers[] = {data, NULL, data + 5};
+   const size_t lengths[] = {16, 0, 3};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertHex(jsonHandle, "digest", data, sizeof(data));
+   kJSON_InsertArrayHex(jsonHandle, "registers", registers, lengths, array_size(registers));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertRaw_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"config\":{\"mode\":\"auto\",\"gain\":[1,2]},\"caps\":[\"a\",\"b\\\"]\"],\"id\":3,\"none\":null}";
+#else
+   const char expected[] = "{\n"
+                           "\"config\":\t{\"mode\":\"auto\",\"gain\":[1,2]},\n"
+                           "\"caps\":\t[\"a\",\"b\\\"]\"],\n"
+                           "\"id\":\t3,\n"
+                           "\"none\":\tnull\n"
+                           "}";
+#endif
+
+   const char config[] = "{\"mode\":\"auto\",\"gain\":[1,2]}";
+   const char caps[] = "[\"a\",\"b\\\"]\"]";
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertRaw(jsonHandle, "config", config, strlen(config));
+   kJSON_InsertRaw(jsonHandle, "caps", caps, strlen(caps));
+   kJSON_InsertNumber(jsonHandle, "id", 3);
+   kJSON_InsertRaw(jsonHandle, "none", NULL, 0);
+   kJSON_ExitRoot(jsonHandle);
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertRaw_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"config\":{\"mode\":\"auto\",\"gain\":[1,2]},\"caps\":[\"a\",\"b\\\"]\"],\"id\":3,\"none\":null}";
+#else
+   const char expected[] = "{\n"
+                           "\"config\":\t{\"mode\":\"auto\",\"gain\":[1,2]},\n"
+                           "\"caps\":\t[\"a\",\"b\\\"]\"],\n"
+                           "\"id\":\t3,\n"
+                           "\"none\":\tnull\n"
+                           "}";
+#endif
+
+   const char config[] = "{\"mode\":\"auto\",\"gain\":[1,2]}";
+   const char caps[] = "[\"a\",\"b\\\"]\"]";
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertRaw(jsonHandle, "config", config, strlen(config));
+   kJSON_InsertRaw(jsonHandle, "caps", caps, strlen(caps));
+   kJSON_InsertNumber(jsonHandle, "id", 3);
+   kJSON_InsertRaw(jsonHandle, "none", NULL, 0);
+   kJSON_ExitRoot(jsonHandle);
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+#if !CONFIG_KJSON_NO_RAW_CHECK
+static bool kJSON_InsertRawReject_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"valid\":[{\"a\":\"}\"}, 2]}";
+#else
+   const char expected[] = "{\n"
+                           "\"valid\":\t[{\"a\":\"}\"}, 2]\n"
+                           "}";
+#endif
+   const char *const invalid[] = {"", " ", "[1}", "{\"a\":[1]", "\"open", "\"a\\\"", "1 2", "{} 1", "\"a\"b", "]", "1,2", "\"caf\xC3\xA9\""};
+   const char valid[] = "[{\"a\":\"}\"}, 2]";
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   // Values that are not a single value with closed strings and matched
+   // brackets are not inserted, nor is non-ASCII text in ascii mode
+   json.ascii = KJSON_ASCII_REJECT;
+   kJSON_InitRoot(jsonHandle);
+   for (size_t i = 0; i < array_size(invalid); i++)
+   {
+      kJSON_InsertRaw(jsonHandle, "invalid", invalid[i], strlen(invalid[i]));
+   }
+   kJSON_InsertRaw(jsonHandle, "valid", valid, strlen(valid));
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+   if (!json.rejected)
+   {
+      printf("\n%s: didn't reject\n", __func__);
+      printf("File: ./%s:%d\n\n", __FILE__, __LINE__);
+      return false;
+   }
+
+   return true;
+}
+#endif
+
+static bool kJSON_InsertObject_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"object\":{\"key\":\"value\"}}";
+#else
+   const char expected[] = "{\n"
+                           "\"object\":\t{\n"
+                           "\t\"key\":\t\"value\"\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   kJSON_InitRoot(jsonHandle);
+
+   kJSON_EnterObject(jsonHandle, "object");
+   {
+      kJSON_InsertString(jsonHandle, "key", "value");
+   }
+   kJSON_ExitObject(jsonHandle);
+
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertObject_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"object\":{\"key\":\"value\"}}";
+#else
+   const char expected[] = "{\n"
+                           "\"object\":\t{\n"
+                           "\t\"key\": \"value\"\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   kJSON_InitRoot(jsonHandle);
+
+   kJSON_EnterObject(jsonHandle, "object");
+   {
+      kJSON_InsertString(jsonHandle, "key", "value");
+   }
+   kJSON_ExitObject(jsonHandle);
+
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_EnterArray_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"array\":[{\"foo\":\"bar\"},{\"baz\":123}]}";
+#else
+   const char expected[] = "{\n"
+                           "\"array\":\t[\n"
+                           "\t{\n"
+                           "\t\t\"foo\":\t\"bar\"\n"
+                           "\t},\n"
+                           "\t{\n"
+                           "\t\t\"baz\":\t123\n"
+                           "\t}\n"
+                           "]\n"
+                           "}";
+#endif
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   kJSON_InitRoot(jsonHandle);
+
+   kJSON_EnterArray(jsonHandle, "array");
+   {
+      kJSON_EnterObject(jsonHandle, NULL);
+      {
+         kJSON_InsertString(jsonHandle, "foo", "bar");
+      }
+      kJSON_ExitObject(jsonHandle);
+
+      kJSON_EnterObject(jsonHandle, NULL);
+      {
+         kJSON_InsertNumber(jsonHandle, "baz", 123);
+      }
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitArray(jsonHandle);
+
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_EnterArray_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"array\":[{\"foo\":\"bar\"},{\"baz\":123}]}";
+#else
+   const char expected[] = "{\n"
+                           "\"array\":\t[\n"
+                           "\t{\n"
+                           "\t\t\"foo\":\t\"bar\"\n"
+                           "\t},\n"
+                           "\t{\n"
+                           "\t\t\"baz\":\t123\n"
+                           "\t}\n"
+                           "]\n"
+                           "}";
+#endif
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   kJSON_InitRoot(jsonHandle);
+
+   kJSON_EnterArray(jsonHandle, "array");
+   {
+      kJSON_EnterObject(jsonHandle, NULL);
+      {
+         kJSON_InsertString(jsonHandle, "foo", "bar");
+      }
+      kJSON_ExitObject(jsonHandle);
+
+      kJSON_EnterObject(jsonHandle, NULL);
+      {
+         kJSON_InsertNumber(jsonHandle, "baz", 123);
+      }
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitArray(jsonHandle);
+
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+   return true;
+}
+
+static bool kJSON_InsertPreparedKey_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"\\\"tag\\\"\":\"x\",\"list\":[1,2],\"child\":{\"id\":true}}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t7,\n"
+                           "\"\\\"tag\\\"\":\t\"x\",\n"
+                           "\"list\":\t[1, 2],\n"
+                           "\"child\":\t{\n"
+                           "\t\"id\":\ttrue\n"
+                           "}\n"
+                           "}";
+#endif
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   char idBuffer[16];
+   char tagBuffer[16];
+   char listBuffer[16];
+   char childBuffer[16];
+   kjson_key_t id;
+   kjson_key_t tag;
+   kjson_key_t list;
+   kjson_key_t child;
+   const int array[] = {1, 2};
+
+   if (!kJSON_PrepareKey(&id, idBuffer, sizeof(idBuffer), "id", KJSON_ASCII_OFF) ||
+       !kJSON_PrepareKey(&tag, tagBuffer, sizeof(tagBuffer), "\"tag\"", KJSON_ASCII_OFF) ||
+       !kJSON_PrepareKey(&list, listBuffer, sizeof(listBuffer), "list", KJSON_ASCII_OFF) ||
+       !kJSON_PrepareKey(&child, childBuffer, sizeof(childBuffer), "child", KJSON_ASCII_OFF) ||
+       kJSON_PrepareKey(&id, idBuffer, 4, "id", KJSON_ASCII_OFF))
+   {
+      printf("\n%s FAILED: keys not prepared\n", __func__);
+      return false;
+   }
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertNumberWithKey(jsonHandle, &id, 7);
+   kJSON_InsertStringWithKey(jsonHandle, &tag, "x");
+   kJSON_InsertArrayIntWithKey(jsonHandle, &list, array, array_size(array));
+   kJSON_EnterObjectWithKey(jsonHandle, &child);
+   {
+      kJSON_InsertBooleanWithKey(jsonHandle, &id, true);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertPreparedKey_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"\\\"tag\\\"\":\"x\",\"list\":[1,2],\"child\":{\"id\":true}}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t7,\n"
+                           "\"\\\"tag\\\"\":\t\"x\",\n"
+                           "\"list\":\t[1, 2],\n"
+                           "\"child\":\t{\n"
+                           "\t\"id\":\ttrue\n"
+                           "}\n"
+                           "}";
+#endif
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+
+   char idBuffer[16];
+   char tagBuffer[16];
+   char listBuffer[16];
+   char childBuffer[16];
+   kjson_key_t id;
+   kjson_key_t tag;
+   kjson_key_t list;
+   kjson_key_t child;
+   const int array[] = {1, 2};
+
+   if (!kJSON_PrepareKey(&id, idBuffer, sizeof(idBuffer), "id", KJSON_ASCII_OFF) ||
+       !kJSON_PrepareKey(&tag, tagBuffer, sizeof(tagBuffer), "\"tag\"", KJSON_ASCII_OFF) ||
+       !kJSON_PrepareKey(&list, listBuffer, sizeof(listBuffer), "list", KJSON_ASCII_OFF) ||
+       !kJSON_PrepareKey(&child, childBuffer, sizeof(childBuffer), "child", KJSON_ASCII_OFF) ||
+       kJSON_PrepareKey(&id, idBuffer, 4, "id", KJSON_ASCII_OFF))
+   {
+      printf("\n%s FAILED: keys not prepared\n", __func__);
+      return false;
+   }
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertNumberWithKey(jsonHandle, &id, 7);
+   kJSON_InsertStringWithKey(jsonHandle, &tag, "x");
+   kJSON_InsertArrayIntWithKey(jsonHandle, &list, array, array_size(array));
+   kJSON_EnterObjectWithKey(jsonHandle, &child);
+   {
+      kJSON_InsertBooleanWithKey(jsonHandle, &id, true);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertLiteralKey_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"name\":\"x\",\"list\":[1,2],\"child\":{\"ok\":true,\"none\":null}}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t7,\n"
+                           "\"name\":\t\"x\",\n"
+                           "\"list\":\t[1, 2],\n"
+                           "\"child\":\t{\n"
+                           "\t\"ok\":\ttrue,\n"
+                           "\t\"none\":\tnull\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertLiteralKeys(&json);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_InsertLiteralKey_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":7,\"name\":\"x\",\"list\":[1,2],\"child\":{\"ok\":true,\"none\":null}}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t7,\n"
+                           "\"name\":\t\"x\",\n"
+                           "\"list\":\t[1, 2],\n"
+                           "\"child\":\t{\n"
+                           "\t\"ok\":\ttrue,\n"
+                           "\t\"none\":\tnull\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   InsertLiteralKeys(&json);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static void InsertLiteralKeys(kjson_t *const jsonHandle)
+{
+   // Prepared at compile time, the same output as kJSON_PrepareKey
+   const int array[] = {1, 2};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertNumberWithKey(jsonHandle, KJSON_KEY("id"), 7);
+   kJSON_InsertStringWithKey(jsonHandle, KJSON_KEY("name"), "x");
+   kJSON_InsertArrayIntWithKey(jsonHandle, KJSON_KEY("list"), array, array_size(array));
+   kJSON_EnterObjectWithKey(jsonHandle, KJSON_KEY("child"));
+   {
+      kJSON_InsertBooleanWithKey(jsonHandle, KJSON_KEY("ok"), true);
+      kJSON_InsertNullWithKey(jsonHandle, KJSON_KEY("none"));
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+}
+
+static bool kJSON_RenderTemplate_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"people\":{\"bob\":{\"name\":\"Bo\\\"b\",\"job\":null,\"age\":32,\"married\":false}},\"balance\":-300}";
+#else
+   const char expected[] = "{\n"
+                           "\"people\":\t{\n"
+                           "\t\"bob\":\t{\n"
+                           "\t\t\"name\":\t\"Bo\\\"b\",\n"
+                           "\t\t\"job\":\tnull,\n"
+                           "\t\t\"age\":\t32,\n"
+                           "\t\t\"married\":\tfalse\n"
+                           "\t}\n"
+                           "},\n"
+                           "\"balance\":\t-300\n"
+                           "}";
+#endif
+
+   char text[sizeof(expected)] = {0};
+   kjson_slot_t slots[5];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_EnterObject(jsonHandle, "people");
+   {
+      kJSON_EnterObject(jsonHandle, "bob");
+      {
+         kJSON_InsertSlot(&template, "name", KJSON_SLOT_STRING, 0);
+         kJSON_InsertSlot(&template, "job", KJSON_SLOT_STRING, 0);
+         kJSON_InsertSlot(&template, "age", KJSON_SLOT_UNSIGNED_NUMBER, 0);
+         kJSON_InsertSlot(&template, "married", KJSON_SLOT_BOOLEAN, 0);
+      }
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_InsertSlot(&template, "balance", KJSON_SLOT_NUMBER, 0);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[5];
+   values[0].string = "Alice";
+   values[1].string = "Nurse";
+   values[2].unsignedNumber = 4000000000u;
+   values[3].boolean = true;
+   values[4].number = 123456789;
+   char first[256];
+   kJSON_RenderTemplate(&template, values, first, sizeof(first));
+
+   values[0].string = "Bo\"b";
+   values[1].string = NULL;
+   values[2].unsignedNumber = 32;
+   values[3].boolean = false;
+   values[4].number = -300;
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplate_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"people\":{\"bob\":{\"name\":\"Bo\\\"b\",\"job\":null,\"age\":32,\"married\":false}},\"balance\":-300}";
+#else
+   const char expected[] = "{\n"
+                           "\"people\":\t{\n"
+                           "\t\"bob\":\t{\n"
+                           "\t\t\"name\":\t\"Bo\\\"b\",\n"
+                           "\t\t\"job\":\tnull,\n"
+                           "\t\t\"age\":\t32,\n"
+                           "\t\t\"married\":\tfalse\n"
+                           "\t}\n"
+                           "},\n"
+                           "\"balance\":\t-300\n"
+                           "}";
+#endif
+
+   char text[sizeof(expected)] = {0};
+   kjson_slot_t slots[5];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_EnterObject(jsonHandle, "people");
+   {
+      kJSON_EnterObject(jsonHandle, "bob");
+      {
+         kJSON_InsertSlot(&template, "name", KJSON_SLOT_STRING, 0);
+         kJSON_InsertSlot(&template, "job", KJSON_SLOT_STRING, 0);
+         kJSON_InsertSlot(&template, "age", KJSON_SLOT_UNSIGNED_NUMBER, 0);
+         kJSON_InsertSlot(&template, "married", KJSON_SLOT_BOOLEAN, 0);
+      }
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_InsertSlot(&template, "balance", KJSON_SLOT_NUMBER, 0);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[5];
+   values[0].string = "Alice";
+   values[1].string = "Nurse";
+   values[2].unsignedNumber = 4000000000u;
+   values[3].boolean = true;
+   values[4].number = 123456789;
+   char first[256];
+   kJSON_RenderTemplate(&template, values, first, sizeof(first));
+
+   values[0].string = "Bo\"b";
+   values[1].string = NULL;
+   values[2].unsignedNumber = 32;
+   values[3].boolean = false;
+   values[4].number = -300;
+   char output[sizeof(expected) - 1] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateGather_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"label\":\"boot\",\"v\":42}";
+#else
+   const char expected[] = "{\n"
+                           "\"label\":\t\"boot\",\n"
+                           "\"v\":\t42\n"
+                           "}";
+#endif
+
+   // Strings below the threshold are copied into the template text
+   char text[sizeof(expected)] = {0};
+   kjson_slot_t slots[1];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+   kjson_reference_t references[1];
+   kjson_gather_t gather = KJSON_GATHER_INITIALISE(references, array_size(references), 16);
+
+   jsonHandle->gather = &gather;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "label", "boot");
+   kJSON_InsertSlot(&template, "v", KJSON_SLOT_NUMBER, 0);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[1];
+   values[0].number = 42;
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateGather_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"label\":\"2023-04-29 12:00:00 boot complete\",\"v\":42}";
+#else
+   const char expected[] = "{\n"
+                           "\"label\":\t\"2023-04-29 12:00:00 boot complete\",\n"
+                           "\"v\":\t42\n"
+                           "}";
+#endif
+
+   // A long string is referenced, it is not in the template text so the template is not rendered
+   char text[sizeof(expected)] = {0};
+   kjson_slot_t slots[1];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+   kjson_reference_t references[1];
+   kjson_gather_t gather = KJSON_GATHER_INITIALISE(references, array_size(references), 16);
+
+   jsonHandle->gather = &gather;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "label", "2023-04-29 12:00:00 boot complete");
+   kJSON_InsertSlot(&template, "v", KJSON_SLOT_NUMBER, 0);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[1];
+   values[0].number = 42;
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateRollback_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"v\":42,\"x\":1}";
+#else
+   const char expected[] = "{\n"
+                           "\"v\":\t42,\n"
+                           "\"x\":\t1\n"
+                           "}";
+#endif
+
+   // The slot recorded after the checkpoint is rolled back with its text
+   char text[64] = {0};
+   kjson_slot_t slots[2];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+   kjson_checkpoint_t checkpoint;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertSlot(&template, "v", KJSON_SLOT_NUMBER, 0);
+   kJSON_Checkpoint(jsonHandle, &checkpoint);
+   kJSON_InsertSlot(&template, "w", KJSON_SLOT_NUMBER, 0);
+   kJSON_Rollback(jsonHandle, &checkpoint);
+   kJSON_InsertNumber(jsonHandle, "x", 1);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[2];
+   values[0].number = 42;
+   values[1].number = 71;
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateRollback_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"v\":42,\"x\":1}";
+#else
+   const char expected[] = "{\n"
+                           "\"v\":\t42,\n"
+                           "\"x\":\t1\n"
+                           "}";
+#endif
+
+   // The slot recorded after the checkpoint is rolled back with its text
+   char text[64] = {0};
+   kjson_slot_t slots[2];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+   kjson_checkpoint_t checkpoint;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertSlot(&template, "v", KJSON_SLOT_NUMBER, 0);
+   kJSON_Checkpoint(jsonHandle, &checkpoint);
+   kJSON_InsertSlot(&template, "w", KJSON_SLOT_NUMBER, 0);
+   kJSON_Rollback(jsonHandle, &checkpoint);
+   kJSON_InsertNumber(jsonHandle, "x", 1);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[2];
+   values[0].number = 42;
+   values[1].number = 71;
+   char output[sizeof(expected) - 1] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateUnfinished_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"o\":{\"a\":5}}";
+#else
+   const char expected[] = "{\n"
+                           "\"o\":\t{\n"
+                           "\t\"a\":\t5\n"
+                           "}\n"
+                           "}";
+#endif
+
+   char text[64] = {0};
+   kjson_slot_t slots[1];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_EnterObject(jsonHandle, "o");
+   kJSON_InsertSlot(&template, "a", KJSON_SLOT_NUMBER, 0);
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[1];
+   values[0].number = 5;
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateUnfinished_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"o\":{\"a\":5}}";
+#else
+   const char expected[] = "{\n"
+                           "\"o\":\t{\n"
+                           "\t\"a\":\t5\n"
+                           "}\n"
+                           "}";
+#endif
+
+   // The closing brackets are not written before kJSON_ExitRoot, the template is not rendered
+   char text[64] = {0};
+   kjson_slot_t slots[1];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_EnterObject(jsonHandle, "o");
+   kJSON_InsertSlot(&template, "a", KJSON_SLOT_NUMBER, 0);
+
+   kjson_value_t values[1];
+   values[0].number = 5;
+   char output[64] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateSlotType_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"s\":\"on\"}";
+#else
+   const char expected[] = "{\n"
+                           "\"s\":\t\"on\"\n"
+                           "}";
+#endif
+
+   char text[sizeof(expected)] = {0};
+   kjson_slot_t slots[1];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertSlot(&template, "s", KJSON_SLOT_STRING, 0);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[1];
+   values[0].string = "on";
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_RenderTemplateSlotType_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"s\":\"on\"}";
+#else
+   const char expected[] = "{\n"
+                           "\"s\":\t\"on\"\n"
+                           "}";
+#endif
+
+   // A slot of unknown type is refused, the template is truncated and not rendered
+   char text[sizeof(expected)] = {0};
+   kjson_slot_t slots[1];
+   kjson_template_t template = KJSON_TEMPLATE_INITIALISE(text, sizeof(text), slots, array_size(slots));
+   kjson_t *jsonHandle = &template.json;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertSlot(&template, "s", (kjson_slot_e)(KJSON_SLOT_STRING + 1), 0);
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_value_t values[1];
+   values[0].string = "on";
+   char output[sizeof(expected)] = {0};
+   const size_t size = kJSON_RenderTemplate(&template, values, output, sizeof(output));
+   struct
+   {
+      const char *root;
+      size_t size;
+      bool truncated;
+   } json = {output, size, 0 == size};
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Sink_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[0,1,2,3,4,5,6,7,8,9],\"people\":{\"bob\":{\"name\":\"Bob\",\"job\":null,\"age\":32,\"married\":false,\"balance\":-300},\"none\":{}}}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[0, 1, 2, 3, 4, 5, 6, 7, 8, 9],\n"
+                           "\"people\":\t{\n"
+                           "\t\"bob\":\t{\n"
+                           "\t\t\"name\":\t\"Bob\",\n"
+                           "\t\t\"job\":\tnull,\n"
+                           "\t\t\"age\":\t32,\n"
+                           "\t\t\"married\":\tfalse,\n"
+                           "\t\t\"balance\":\t-300\n"
+                           "\t},\n"
+                           "\t\"none\":\t{\n"
+                           "\t}\n"
+                           "}\n"
+                           "}";
+#endif
+
+   // The document is streamed through a buffer smaller than its largest entries
+   char output[sizeof(expected)] = {0};
+   sink_t sink = {output, 0, sizeof(output) - 1, false};
+   char root[48] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   const int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+   json.write = SinkWrite;
+   json.context = &sink;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_EnterObject(jsonHandle, "people");
+   {
+      kJSON_EnterObject(jsonHandle, "bob");
+      {
+         kJSON_InsertString(jsonHandle, "name", "Bob");
+         kJSON_InsertNull(jsonHandle, "job");
+         kJSON_InsertUnsignedNumber(jsonHandle, "age", 32);
+         kJSON_InsertBoolean(jsonHandle, "married", false);
+         kJSON_InsertNumber(jsonHandle, "balance", -300);
+      }
+      kJSON_ExitObject(jsonHandle);
+      kJSON_EnterObject(jsonHandle, "none");
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+   sink.truncated = json.truncated;
+
+   CHECK_JSON_GOOD(sink, expected);
+
+   return true;
+}
+
+static bool kJSON_Sink_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"digits\":[0,1,2,3,4,5,6,7,8,9],\"people\":{\"bob\":{\"name\":\"Bob\",\"job\":null,\"age\":32,\"married\":false,\"balance\":-300},\"none\":{}}}";
+#else
+   const char expected[] = "{\n"
+                           "\"digits\":\t[0, 1, 2, 3, 4, 5, 6, 7, 8, 9],\n"
+                           "\"people\":\t{\n"
+                           "\t\"bob\":\t{\n"
+                           "\t\t\"name\":\t\"Bob\",\n"
+                           "\t\t\"job\":\tnull,\n"
+                           "\t\t\"age\":\t32,\n"
+                           "\t\t\"married\":\tfalse,\n"
+                           "\t\t\"balance\":\t-300\n"
+                           "\t},\n"
+                           "\t\"none\":\t{\n"
+                           "\t}\n"
+                           "}\n"
+                           "}";
+#endif
+
+   // The document is streamed through a buffer smaller than its largest entries
+   char output[sizeof(expected) - 1] = {0};
+   sink_t sink = {output, 0, sizeof(output) - 1, false};
+   char root[48] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   const int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+   json.write = SinkWrite;
+   json.context = &sink;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertArrayInt(jsonHandle, "digits", digits, array_size(digits));
+   kJSON_EnterObject(jsonHandle, "people");
+   {
+      kJSON_EnterObject(jsonHandle, "bob");
+      {
+         kJSON_InsertString(jsonHandle, "name", "Bob");
+         kJSON_InsertNull(jsonHandle, "job");
+         kJSON_InsertUnsignedNumber(jsonHandle, "age", 32);
+         kJSON_InsertBoolean(jsonHandle, "married", false);
+         kJSON_InsertNumber(jsonHandle, "balance", -300);
+      }
+      kJSON_ExitObject(jsonHandle);
+      kJSON_EnterObject(jsonHandle, "none");
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+   sink.truncated = json.truncated;
+
+   CHECK_JSON_BAD(sink, expected);
+
+   return true;
+}
+
+static bool kJSON_Gather_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"log\":\"2023-04-29 12:00:00 boot complete\",\"short\":\"ok\",\"lines\":[\"first line of the log\",\"x\",\"needs \\\"escaping\\\" so it is copied\"]}";
+#else
+   const char expected[] = "{\n"
+                           "\"log\":\t\"2023-04-29 12:00:00 boot complete\",\n"
+                           "\"short\":\t\"ok\",\n"
+                           "\"lines\":\t[\"first line of the log\", \"x\", \"needs \\\"escaping\\\" so it is copied\"]\n"
+                           "}";
+#endif
+
+   // Long strings are referenced, so the buffer only needs to hold the rest
+   const char *const log = "2023-04-29 12:00:00 boot complete";
+   const char *const lines[] = {"first line of the log", "x", "needs \"escaping\" so it is copied"};
+   char root[sizeof(expected) - 54] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   kjson_reference_t references[4];
+   kjson_gather_t gather = KJSON_GATHER_INITIALISE(references, array_size(references), 16);
+
+   json.gather = &gather;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "log", log);
+   kJSON_InsertString(jsonHandle, "short", "ok");
+   kJSON_InsertArrayString(jsonHandle, "lines", lines, array_size(lines));
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_iovec_t iov[2 * 2 + 1];
+   char output[sizeof(expected)] = {0};
+   sink_t sink = {output, 0, sizeof(output) - 1, json.truncated};
+   size_t size = 0;
+   const size_t count = kJSON_Gather(jsonHandle, iov, array_size(iov), &size);
+   for (size_t i = 0; i < count; i++)
+   {
+      SinkWrite(&sink, iov[i].base, iov[i].length);
+   }
+   sink.truncated |= (0 == count) || (size != sink.size);
+
+   CHECK_JSON_GOOD(sink, expected);
+
+   return true;
+}
+
+static bool kJSON_Gather_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"log\":\"2023-04-29 12:00:00 boot complete\",\"short\":\"ok\",\"lines\":[\"first line of the log\",\"x\",\"needs \\\"escaping\\\" so it is copied\"]}";
+#else
+   const char expected[] = "{\n"
+                           "\"log\":\t\"2023-04-29 12:00:00 boot complete\",\n"
+                           "\"short\":\t\"ok\",\n"
+                           "\"lines\":\t[\"first line of the log\", \"x\", \"needs \\\"escaping\\\" so it is copied\"]\n"
+                           "}";
+#endif
+
+   // Long strings are referenced, so the buffer only needs to hold the rest
+   const char *const log = "2023-04-29 12:00:00 boot complete";
+   const char *const lines[] = {"first line of the log", "x", "needs \"escaping\" so it is copied"};
+   char root[sizeof(expected) - 54] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   kjson_reference_t references[4];
+   kjson_gather_t gather = KJSON_GATHER_INITIALISE(references, array_size(references), 16);
+
+   json.gather = &gather;
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "log", log);
+   kJSON_InsertString(jsonHandle, "short", "ok");
+   kJSON_InsertArrayString(jsonHandle, "lines", lines, array_size(lines));
+   kJSON_ExitRoot(jsonHandle);
+
+   kjson_iovec_t iov[2 * 2];
+   char output[sizeof(expected)] = {0};
+   sink_t sink = {output, 0, sizeof(output) - 1, json.truncated};
+   size_t size = 0;
+   const size_t count = kJSON_Gather(jsonHandle, iov, array_size(iov), &size);
+   for (size_t i = 0; i < count; i++)
+   {
+      SinkWrite(&sink, iov[i].base, iov[i].length);
+   }
+   sink.truncated |= (0 == count) || (size != sink.size);
+
+   CHECK_JSON_BAD(sink, expected);
+
+   return true;
+}
+
+static bool kJSON_Batch_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":1,\"name\":\"alpha\"}\n"
+                           "{\"id\":2,\"name\":\"beta\"}\n"
+                           "{\"id\":3,\"name\":\"gamma\"}\n";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t1,\n"
+                           "\"name\":\t\"alpha\"\n"
+                           "}\n"
+                           "{\n"
+                           "\"id\":\t2,\n"
+                           "\"name\":\t\"beta\"\n"
+                           "}\n"
+                           "{\n"
+                           "\"id\":\t3,\n"
+                           "\"name\":\t\"gamma\"\n"
+                           "}\n";
+#endif
+
+   // Records are appended one per line
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   const char *const names[] = {"alpha", "beta", "gamma"};
+
+   json.batch = true;
+   for (size_t i = 0; i < array_size(names); i++)
+   {
+      kJSON_InitRoot(jsonHandle);
+      kJSON_InsertUnsignedNumber(jsonHandle, "id", (unsigned int)i + 1);
+      kJSON_InsertString(jsonHandle, "name", names[i]);
+      kJSON_ExitRoot(jsonHandle);
+   }
+   json.truncated |= (json.records != array_size(names)) || (json.size != strlen(json.root));
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Batch_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":1,\"name\":\"alpha\"}\n"
+                           "{\"id\":2,\"name\":\"beta\"}\n"
+                           "{\"id\":3,\"name\":\"gamma\"}\n";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t1,\n"
+                           "\"name\":\t\"alpha\"\n"
+                           "}\n"
+                           "{\n"
+                           "\"id\":\t2,\n"
+                           "\"name\":\t\"beta\"\n"
+                           "}\n"
+                           "{\n"
+                           "\"id\":\t3,\n"
+                           "\"name\":\t\"gamma\"\n"
+                           "}\n";
+#endif
+
+   // The last record does not fit whole, it is rolled back
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   const char *const names[] = {"alpha", "beta", "gamma"};
+
+   json.batch = true;
+   for (size_t i = 0; i < array_size(names); i++)
+   {
+      kJSON_InitRoot(jsonHandle);
+      kJSON_InsertUnsignedNumber(jsonHandle, "id", (unsigned int)i + 1);
+      kJSON_InsertString(jsonHandle, "name", names[i]);
+      kJSON_ExitRoot(jsonHandle);
+   }
+   json.truncated |= (json.records != array_size(names)) || (json.size != strlen(json.root));
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Rollback_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":1,\"details\":{\"level\":3},\"summary\":\"short\"}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t1,\n"
+                           "\"details\":\t{\n"
+                           "\t\"level\":\t3\n"
+                           "},\n"
+                           "\"summary\":\t\"short\"\n"
+                           "}";
+#endif
+
+   // The optional sections that do not fit whole are dropped
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   kjson_checkpoint_t checkpoint;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertUnsignedNumber(jsonHandle, "id", 1);
+   kJSON_Checkpoint(jsonHandle, &checkpoint);
+   kJSON_EnterObject(jsonHandle, "details");
+   {
+      kJSON_InsertUnsignedNumber(jsonHandle, "level", 3);
+      kJSON_InsertString(jsonHandle, "trace", "a trace that is too long for the buffer");
+   }
+   kJSON_ExitObject(jsonHandle);
+   if (json.truncated && kJSON_Rollback(jsonHandle, &checkpoint))
+   {
+      kJSON_EnterObject(jsonHandle, "details");
+      kJSON_InsertUnsignedNumber(jsonHandle, "level", 3);
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_Checkpoint(jsonHandle, &checkpoint);
+   kJSON_InsertString(jsonHandle, "summary", "a summary that is too long for the buffer");
+   if (json.truncated && kJSON_Rollback(jsonHandle, &checkpoint))
+   {
+      kJSON_InsertString(jsonHandle, "summary", "short");
+   }
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Rollback_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"id\":1,\"details\":{\"level\":3},\"summary\":\"short\"}";
+#else
+   const char expected[] = "{\n"
+                           "\"id\":\t1,\n"
+                           "\"details\":\t{\n"
+                           "\t\"level\":\t3\n"
+                           "},\n"
+                           "\"summary\":\t\"short\"\n"
+                           "}";
+#endif
+
+   // The optional sections that do not fit whole are dropped
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   kjson_t *jsonHandle = &json;
+   kjson_checkpoint_t checkpoint;
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertUnsignedNumber(jsonHandle, "id", 1);
+   kJSON_Checkpoint(jsonHandle, &checkpoint);
+   kJSON_EnterObject(jsonHandle, "details");
+   {
+      kJSON_InsertUnsignedNumber(jsonHandle, "level", 3);
+      kJSON_InsertString(jsonHandle, "trace", "a trace that is too long for the buffer");
+   }
+   kJSON_ExitObject(jsonHandle);
+   if (json.truncated && kJSON_Rollback(jsonHandle, &checkpoint))
+   {
+      kJSON_EnterObject(jsonHandle, "details");
+      kJSON_InsertUnsignedNumber(jsonHandle, "level", 3);
+      kJSON_ExitObject(jsonHandle);
+   }
+   kJSON_Checkpoint(jsonHandle, &checkpoint);
+   kJSON_InsertString(jsonHandle, "summary", "a summary that is too long for the buffer");
+   if (json.truncated && kJSON_Rollback(jsonHandle, &checkpoint))
+   {
+      kJSON_InsertString(jsonHandle, "summary", "short");
+   }
+   kJSON_ExitRoot(jsonHandle);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Measure_PASS(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"name\":\"caf\\u00e9 \\\"x\\\"\",\"id\":-42,\"values\":[1,-20,null,4000],\"tags\":[\"a\",null],\"inner\":{\"on\":true,\"off\":null},\"empty\":[]}";
+#else
+   const char expected[] = "{\n"
+                           "\"name\":\t\"caf\\u00e9 \\\"x\\\"\",\n"
+                           "\"id\":\t-42,\n"
+                           "\"values\":\t[1, -20, null, 4000],\n"
+                           "\"tags\":\t[\"a\", null],\n"
+                           "\"inner\":\t{\n"
+                           "\t\"on\":\ttrue,\n"
+                           "\t\"off\":\tnull\n"
+                           "},\n"
+                           "\"empty\":\t[\n"
+                           "]\n"
+                           "}";
+#endif
+
+   // The size measured without a buffer is the size of the output
+   kjson_t measure = KJSON_INITIALISE(NULL, 0);
+   measure.ascii = KJSON_ASCII_REPLACE;
+   InsertMeasured(&measure);
+   if (measure.truncated || (measure.size != sizeof(expected) - 1))
+   {
+      printf("\n%s: measured %zu, expected %zu\n", __func__, measure.size, sizeof(expected) - 1);
+      return false;
+   }
+
+   char root[sizeof(expected)] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   json.ascii = KJSON_ASCII_REPLACE;
+   InsertMeasured(&json);
+
+   CHECK_JSON_GOOD(json, expected);
+
+   return true;
+}
+
+static bool kJSON_Measure_FAIL(void)
+{
+#if CONFIG_KJSON_SMALLEST
+   const char expected[] = "{\"name\":\"caf\\u00e9 \\\"x\\\"\",\"id\":-42,\"values\":[1,-20,null,4000],\"tags\":[\"a\",null],\"inner\":{\"on\":true,\"off\":null},\"empty\":[]}";
+#else
+   const char expected[] = "{\n"
+                           "\"name\":\t\"caf\\u00e9 \\\"x\\\"\",\n"
+                           "\"id\":\t-42,\n"
+                           "\"values\":\t[1, -20, null, 4000],\n"
+                           "\"tags\":\t[\"a\", null],\n"
+                           "\"inner\":\t{\n"
+                           "\t\"on\":\ttrue,\n"
+                           "\t\"off\":\tnull\n"
+                           "},\n"
+                           "\"empty\":\t[\n"
+                           "]\n"
+                           "}";
+#endif
+
+   // A buffer of the measured size leaves no room for the terminator
+   kjson_t measure = KJSON_INITIALISE(NULL, 0);
+   measure.ascii = KJSON_ASCII_REPLACE;
+   InsertMeasured(&measure);
+   if (measure.truncated || (measure.size != sizeof(expected) - 1))
+   {
+      printf("\n%s: measured %zu, expected %zu\n", __func__, measure.size, sizeof(expected) - 1);
+      return false;
+   }
+
+   char root[sizeof(expected) - 1] = {0};
+   kjson_t json = KJSON_INITIALISE(root, sizeof(root));
+   json.ascii = KJSON_ASCII_REPLACE;
+   InsertMeasured(&json);
+
+   CHECK_JSON_BAD(json, expected);
+
+   return true;
+}
+
+static void InsertMeasured(kjson_t *const jsonHandle)
+{
+   const int values[] = {1, -20, INT_MAX, 4000};
+   const char *const tags[] = {"a", NULL};
+
+   kJSON_InitRoot(jsonHandle);
+   kJSON_InsertString(jsonHandle, "name", "caf\xC3\xA9 \"x\"");
+   kJSON_InsertNumber(jsonHandle, "id", -42);
+   kJSON_InsertArrayInt(jsonHandle, "values", values, array_size(values));
+   kJSON_InsertArrayString(jsonHandle, "tags", tags, array_size(tags));
+   kJSON_EnterObject(jsonHandle, "inner");
+   {
+      kJSON_InsertBoolean(jsonHandle, "on", true);
+      kJSON_InsertNull(jsonHandle, "off");
+   }
+   kJSON_ExitObject(jsonHandle);
+   kJSON_EnterArray(jsonHandle, "empty");
+   kJSON_ExitArray(jsonHandle);
+   kJSON_ExitRoot(jsonHandle);
+}
+
+static bool SinkWrite(void *const context, const char *const data, const size_t size)
+{
+   sink_t *const sink = (sink_t *)context;
+   if (size > sink->space)
+   {
+      return false;
+   }
+   memcpy(sink->root + sink->size, data, size);
+   sink->size += size;
+   sink->space -= size;
    return true;
 }